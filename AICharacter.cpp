@@ -1,23 +1,51 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 #include "AICharacter.h"
-#include "Components/CapsuleComponent.h"
 #include "AIController.h"
 #include "BossFightCharacter.h"
-#include "NavigationSystem.h"
-#include "Perception/PawnSensingComponent.h"
 #include "Math/UnrealMathUtility.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "Kismet/GameplayStatics.h"
+#include "GameFramework/GameStateBase.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "SkillExecutor.h"
+#include "SkillTableAsset.h"
+#include "BossBrainSubsystem.h"
+#include "RoamQuerySubsystem.h"
+#include "PursuitSubsystem.h"
+#include "ThreatSubsystem.h"
+#include "StatusEffectSubsystem.h"
+#include "BossPerceptionSubsystem.h"
+#include "CombatDamageSubsystem.h"
+#include "MeleeReachSubsystem.h"
+#include "FighterPoolSubsystem.h"
+#include "FightRecorder.h"
+#include "BossFightStats.h"
+#include "CombatEventLog.h"
 // Sets default values
 AAICharacter::AAICharacter()
 {
- 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
-	
-	PawnSensing = CreateDefaultSubobject<UPawnSensingComponent>(TEXT("PawnSensing"));
-	AICharacterCompCapsule = CreateDefaultSubobject<UCapsuleComponent>(TEXT("AICharacterCompCapsuleCpp"));
-	AICharacterCompCapsule->SetupAttachment(GetRootComponent());
+ 	// Bosses are updated in batch by UBossBrainSubsystem and never tick on their own
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Same defaults as UPawnSensingComponent
+	SightRadius = 5000.f;
+	PeripheralVisionAngle = 90.f;
+	HearingThreshold = 1400.f;
+	LOSHearingThreshold = 2800.f;
+	SensingInterval = 0.5f;
+	PerceptionIndex = INDEX_NONE;
+
+	MeleeReach = 150.f;
+	MeleeIndex = INDEX_NONE;
 	collision = false;
+	BrainIndex = INDEX_NONE;
+	DamageIndex = INDEX_NONE;
+	PursuitIndex = INDEX_NONE;
+	ThreatIndex = INDEX_NONE;
+	MoveRequestId = 0;
+	RepHealth = 0;
+	bInPool = false;
 
 }
 
@@ -26,242 +54,461 @@ void AAICharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	GetWorldTimerManager().SetTimer(Timer, this, &AAICharacter::NewMovement, 0.01f);
-	
-	PawnSensing->OnSeePawn.AddDynamic(this, &AAICharacter::SeePawn);
-	PawnSensing->OnHearNoise.AddDynamic(this, &AAICharacter::OnHearNoise);
-	AICharacterCompCapsule->OnComponentBeginOverlap.AddDynamic(this, &AAICharacter::BeginOverlap);
+	// Only the server thinks, clients get the results through replication
+	if (HasAuthority())
+	{
+		RoamQueries = GetWorld()->GetSubsystem<URoamQuerySubsystem>();
+		Pursuit = GetWorld()->GetSubsystem<UPursuitSubsystem>();
+		Threat = GetWorld()->GetSubsystem<UThreatSubsystem>();
+		StatusEffects = GetWorld()->GetSubsystem<UStatusEffectSubsystem>();
+		Brain = GetWorld()->GetSubsystem<UBossBrainSubsystem>();
+		Perception = GetWorld()->GetSubsystem<UBossPerceptionSubsystem>();
+	}
+	DamageQueue = GetWorld()->GetSubsystem<UCombatDamageSubsystem>();
+	MeleeReachSystem = GetWorld()->GetSubsystem<UMeleeReachSubsystem>();
 
-	FirstSkillCooldown = 0;
-	SecondSkillCooldown = 0;
-	ThirdSkillCooldown = 0;
-	
-	AbilityPointRestoreTrigger();
+	if (SkillTableAsset)
+	{
+		SkillTableAsset->BuildTable(SkillTable);
+	}
+	else
+	{
+		SkillTable.Assign(GBossDefaultSkills);
+	}
+
+	// Pooled bosses join when they are taken out of the pool
+	if (!bInPool)
+	{
+		JoinCombat();
+	}
 }
 
-// Called every frame
-void AAICharacter::Tick(float DeltaTime)
+void AAICharacter::JoinCombat()
 {
-	Super::Tick(DeltaTime);
+	const double Now = GetCombatTime();
+	// Bosses carry no potions. Every attribute starts dirty, the first publish replicates all of them
+	Attributes = FFighterAttributes(MaxHealth, Attack, MaxAbilityPoint, AbilityPointRegenRate, 0.f, 0.f, Now);
+	collision = false;
+	MainCharacter = nullptr;
 
-	
+	if (HasAuthority())
+	{
+		Brain->RegisterBoss(this, Now);
+		if (FFightRecorder::IsRecording())
+		{
+			FFightRecorder::RecordFighter(Now, GetUniqueID(), Attributes, SkillTable);
+		}
+		Perception->RegisterBoss(this);
+		Threat->RegisterBoss(this);
+	}
+	DamageIndex = DamageQueue->RegisterTarget(this, &Attributes, FSimpleDelegate::CreateUObject(this, &AAICharacter::HandleDeath),
+		FOnAttributesChanged::CreateUObject(this, &AAICharacter::HandleAttributesChanged));
+	// Clients need the contacts too, to predict player skills
+	MeleeReachSystem->RegisterBoss(this);
 
+	if (!HasAuthority())
+	{
+		// The replicated state may arrive before BeginPlay or before leaving the pool, apply it over the defaults set above
+		OnRep_Health();
+		OnRep_AbilityPoint();
+		OnRep_Cooldowns();
+	}
 }
 
-void AAICharacter::NewMovement()
+void AAICharacter::LeaveCombat()
 {
-	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
-	FNavLocation NavLoc;
-	NavSys->GetRandomReachablePointInRadius(GetActorLocation(), 10000.f, NavLoc);
+	if (Brain)
+	{
+		Brain->UnregisterBoss(this);
+	}
+	if (Perception)
+	{
+		Perception->UnregisterBoss(this);
+	}
+	if (Pursuit)
+	{
+		Pursuit->StopPursuit(this);
+	}
+	if (Threat)
+	{
+		Threat->UnregisterBoss(this);
+	}
+	// Effects know the boss by its damage index, they go first
+	if (StatusEffects)
+	{
+		StatusEffects->RemoveTarget(DamageIndex);
+	}
+	if (MeleeReachSystem)
+	{
+		MeleeReachSystem->UnregisterBoss(this);
+	}
+	if (DamageQueue)
+	{
+		DamageQueue->UnregisterTarget(DamageIndex);
+		DamageIndex = INDEX_NONE;
+	}
+	if (GetWorldTimerManager().IsTimerActive(AbilityPointFullTimer))
+	{
+		GetWorldTimerManager().ClearTimer(AbilityPointFullTimer);
+		FBossFightStats::AddActiveTimers(-1);
+	}
+	if (AIC_Ref)
+	{
+		AIC_Ref->StopMovement();
+	}
+	// Roam results still on their way are dropped
+	++MoveRequestId;
+	MainCharacter = nullptr;
+}
 
-	AIC_Ref = Cast<AAIController>(GetController());
+void AAICharacter::SetInPool(bool bNewInPool)
+{
+	if (bInPool == bNewInPool)
+	{
+		return;
+	}
+	bInPool = bNewInPool;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAICharacter, bInPool, this);
+	OnRep_InPool();
+}
+
+void AAICharacter::OnRep_InPool()
+{
+	// Before BeginPlay the flag only decides whether BeginPlay joins
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+	if (bInPool)
+	{
+		LeaveCombat();
+	}
+	else
+	{
+		JoinCombat();
+	}
+}
+
+void AAICharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (!bInPool)
+	{
+		LeaveCombat();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AAICharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAICharacter, RepHealth, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAICharacter, RepAbilityPoint, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAICharacter, RepCooldowns, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAICharacter, bInPool, Params);
+}
+
+void AAICharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	AIC_Ref = Cast<AAIController>(NewController);
+}
+
+void AAICharacter::UnPossessed()
+{
+	Super::UnPossessed();
+
+	AIC_Ref = nullptr;
+}
+
+void AAICharacter::SetLOD(EBossLOD NewLOD)
+{
+	// Far bosses move and animate in coarse steps, the brain picks their roam targets less often
+	const float TickInterval = FBossLODSettings::TickIntervals[(int32)NewLOD];
+	GetCharacterMovement()->SetComponentTickInterval(TickInterval);
+	GetMesh()->SetComponentTickInterval(TickInterval);
 	if (AIC_Ref)
 	{
-		AIC_Ref->MoveToLocation(NavLoc);
+		AIC_Ref->SetActorTickInterval(TickInterval);
+		AIC_Ref->GetPathFollowingComponent()->SetComponentTickInterval(TickInterval);
+	}
+	Brain->SetRoamInterval(BrainIndex, UBossBrainSubsystem::RoamInterval * FBossLODSettings::RoamIntervalScales[(int32)NewLOD]);
+}
 
-		GetWorldTimerManager().SetTimer(Timer, this, &AAICharacter::NewMovement, 3.0f);
+void AAICharacter::NewMovement()
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_NewMovement);
+	if (AIC_Ref)
+	{
+		Pursuit->StopPursuit(this);
+		RoamQueries->RequestRoamPoint(GetActorLocation(), 10000.f, FRoamQueryDelegate::CreateUObject(this, &AAICharacter::OnRoamPointReady, ++MoveRequestId));
+	}
+}
+
+void AAICharacter::OnRoamPointReady(bool bSuccess, const FVector& Location, uint32 RequestId)
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_OnRoamPointReady);
+	if (bSuccess && AIC_Ref && RequestId == MoveRequestId)
+	{
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::Roam, (float)Location.X, (float)Location.Y);
+		AIC_Ref->MoveToLocation(Location);
 	}
 }
 void AAICharacter::SeePawn(APawn* Pawn)
 {
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_SeePawn);
 	ABossFightCharacter* AISee1 = Cast<ABossFightCharacter>(Pawn);
 
 
 
-	if (AISee1 && collision == false)
+	if (AISee1 && AIC_Ref && collision == false)
 	{
-		GetWorldTimerManager().ClearTimer(Timer);
-
-
-		AIC_Ref->MoveToLocation(GetWorld()->GetFirstPlayerController()->GetPawn()->GetActorLocation(), -1.0f);
-		GetCharacterMovement()->MaxWalkSpeed = 700;
-		GetWorldTimerManager().SetTimer(Timer, this, &AAICharacter::NewMovement, 2.0f);
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::SawPawn, (float)FVector::Dist(GetActorLocation(), Pawn->GetActorLocation()));
+		// The chase follows the flow field of the player, the pending roam move is dropped
+		++MoveRequestId;
+		AIC_Ref->StopMovement();
+		Pursuit->Pursue(this, Pawn, PursuitDuration);
+		ApplyChaseSpeed();
+		Brain->ScheduleRoam(BrainIndex, GetCombatTime() + PursuitDuration);
 		
 	}
 
 }
 void AAICharacter::OnHearNoise(APawn* OtherActor, const FVector& Location, float Volume)
 {
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_OnHearNoise);
 	ABossFightCharacter* AIHear1 = Cast<ABossFightCharacter>(OtherActor);
 	
-	if (AIHear1 && collision == false)
+	if (AIHear1 && AIC_Ref && collision == false)
 	{
-		
-		GetWorldTimerManager().ClearTimer(Timer);
-
-
-		AIC_Ref->MoveToLocation(GetWorld()->GetFirstPlayerController()->GetPawn()->GetActorLocation(), -1);
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::HeardNoise, (float)FVector::Dist(GetActorLocation(), Location), Volume);
+		++MoveRequestId;
+		AIC_Ref->StopMovement();
+		Pursuit->Pursue(this, OtherActor, PursuitDuration);
 
-		GetWorldTimerManager().SetTimer(Timer, this, &AAICharacter::NewMovement, 2.0f);
-		GetCharacterMovement()->MaxWalkSpeed = 700;
+		Brain->ScheduleRoam(BrainIndex, GetCombatTime() + PursuitDuration);
+		ApplyChaseSpeed();
 		
 	}
 }
 
+void AAICharacter::KeepPursuing()
+{
+	// Movement, speed and the pursued player stay as they are, only the end of the chase moves
+	if (AIC_Ref && collision == false && Pursuit->ExtendPursuit(this, PursuitDuration))
+	{
+		Brain->ScheduleRoam(BrainIndex, GetCombatTime() + PursuitDuration);
+		ApplyChaseSpeed();
+	}
+}
 
-void AAICharacter::BeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void AAICharacter::ApplyChaseSpeed()
 {
-	ABossFightCharacter* Carp1 = Cast<ABossFightCharacter>(OtherActor);
-	if(Carp1 && collision == false)
+	// Same type and source, so a new sighting refreshes the effect instead of stacking it
+	StatusEffects->ApplyEffect(DamageIndex, EStatusEffect::MoveSpeed, ChaseSpeed / UStatusEffectSubsystem::GetBaseWalkSpeed(*this), PursuitDuration, 0.f, GetUniqueID());
+}
+
+void AAICharacter::OnMeleeContactBegin(ABossFightCharacter* Player)
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_BossContactBegin);
+	if(!HasAuthority())
+	{
+		return;
+	}
+	if(Player && collision == false)
 	{
 		collision = true;
+		MainCharacter = Player;
+		Pursuit->StopPursuit(this);
+		Perception->NoteEngaged(PerceptionIndex, GetWorld()->GetTimeSeconds());
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::OverlapBegin);
 
-		int A=1,B=4,random;
-		random = FMath::RandRange(A,B);
-        if((GetAIAbilityPoint() < 20 || FirstSkillCooldown > 0) && random == 1 )
-        {
-	        random = 4;
-        }
-		if((GetAIAbilityPoint() < 30 || SecondSkillCooldown > 0) && random == 2)
-		{
-			random = 4;
-		}
-		if((GetAIAbilityPoint() < 40 || ThirdSkillCooldown > 0) && random == 3)
-		{
-			random = 4;
-		}
-		
-		switch(random)
-		{
-		case 1:
-			GetWorldTimerManager().SetTimer(Skills, this, &AAICharacter::FirstSkill, 1.2f);
-			break;
-		case 2:
-			GetWorldTimerManager().SetTimer(Skills, this, &AAICharacter::SecondSkill, 1.4f);
-			break;
-		case 3:
-			GetWorldTimerManager().SetTimer(Skills, this, &AAICharacter::ThirdSkill, 1.6f);
-			break;
-			default:
-				GetWorldTimerManager().SetTimer(Skills, this, &AAICharacter::BasicHit, 1.0f);
-			
-		}
+		// The skill is rolled with the other bosses in the decision phase of the brain
+		Brain->RequestDecision(BrainIndex, GetCombatTime());
 	}
 	
 		
 }
 
-void AAICharacter::FirstSkill()
+void AAICharacter::OnPlayerLeft(const ABossFightCharacter* Player)
 {
-	MainCharacter = Cast<ABossFightCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
-	GEngine->AddOnScreenDebugMessage(-1,5.0f,FColor::Blue,TEXT("1.Yetenek Kullanıldı"));
-	CollisionControl();
-	SetAIAbilityPoint( GetAIAbilityPoint() - 20);
-	MainCharacter->SetHealth(MainCharacter->GetHealth() - 10);
-	KillMainCharacter();
-	FirstSkillCooldown = 4;
-	FirstSkillCooldownReduction();
+	if(MainCharacter == Player)
+	{
+		MainCharacter = nullptr;
+	}
 }
 
-void AAICharacter::SecondSkill()
+void AAICharacter::ExecuteSkill(int32 SkillId)
 {
-	MainCharacter = Cast<ABossFightCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
-	GEngine->AddOnScreenDebugMessage(-1,5.0f,FColor::Blue,TEXT("2.Yetenek Kullanıldı"));
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_BossExecuteSkill);
+	const double Now = GetCombatTime();
+	COMBAT_LOG_EVENT(Now, GetUniqueID(), ECombatEventType::SkillCast, (float)SkillId, SkillTable[SkillId].Damage);
+	// In a raid the player with the most threat takes the hit, not whoever walked into reach first
+	if(ABossFightCharacter* TopTarget = Threat->GetTopTarget(this))
+	{
+		MainCharacter = TopTarget;
+	}
+	// A pooled pawn is no target, whoever pooled it without telling the boss
+	if(MainCharacter && MainCharacter->IsInPool())
+	{
+		MainCharacter = nullptr;
+	}
+	FIGHT_RECORD(EFightRecordType::BossTarget, Now, GetUniqueID(), MainCharacter ? (uint64)MainCharacter->GetUniqueID() : 0);
 	CollisionControl();
-	SetAIAbilityPoint( GetAIAbilityPoint() - 30);
-	MainCharacter->SetHealth(MainCharacter->GetHealth() - 20);
-	KillMainCharacter();
-	SecondSkillCooldown = 6;
-	SecondSkillCooldownReduction();
+	TSkillExecutor<AAICharacter>::Execute(*this, SkillTable[SkillId], Now);
+	FBossFightStats::NoteCast();
 }
 
-void AAICharacter::ThirdSkill()
+void AAICharacter::ApplySkillDamage(float Damage)
 {
-	MainCharacter = Cast<ABossFightCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
-	GEngine->AddOnScreenDebugMessage(-1,5.0f,FColor::Blue,TEXT("3.Yetenek Kullanıldı"));
-	CollisionControl();
-	SetAIAbilityPoint( GetAIAbilityPoint() - 40);
-	MainCharacter->SetHealth(MainCharacter->GetHealth() - 30);
-	KillMainCharacter();
-	ThirdSkillCooldown = 8;
-	ThirdSkillCooldownReduction();
+	if(IsValid(MainCharacter))
+	{
+		DamageQueue->QueueDamage(MainCharacter->DamageIndex, Damage, GetUniqueID());
+	}
 }
 
-void AAICharacter::BasicHit()
+void AAICharacter::HandleDeath()
 {
-	MainCharacter = Cast<ABossFightCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
-	GEngine->AddOnScreenDebugMessage(-1,5.0f,FColor::Blue,TEXT("Temel Saldiri Kullanildi"));
-	CollisionControl();
-	MainCharacter->SetHealth(MainCharacter->GetHealth() - 5);
-	KillMainCharacter();
+	COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::Death, GetHealth());
+	OnDeath.Broadcast();
+	// Dead bosses wait in the pool for the next fight
+	if(HasAuthority())
+	{
+		FIGHT_RECORD(EFightRecordType::Death, GetCombatTime(), GetUniqueID());
+		GetWorld()->GetSubsystem<UFighterPoolSubsystem>()->Release(this);
+	}
+}
+
+void AAICharacter::SetHealth(float NewHealth)
+{
+	if(DamageQueue && DamageIndex != INDEX_NONE)
+	{
+		DamageQueue->SetHealth(DamageIndex, NewHealth);
+	}
+	else
+	{
+		Attributes.SetHealth(NewHealth);
+	}
 }
 
-void AAICharacter::KillMainCharacter()
+void AAICharacter::HandleAttributesChanged(uint32 ChangedMask)
 {
-	MainCharacter = Cast<ABossFightCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
-	if(MainCharacter->GetHealth() <= 0)
+	if(ChangedMask & FighterAttributeBit(EFighterAttribute::Health))
+	{
+		UpdateReplicatedHealth();
+	}
+	if(ChangedMask & FighterAttributeBit(EFighterAttribute::AbilityPoint))
 	{
-		MainCharacter->Destroy();
+		UpdateReplicatedAbilityPoint();
+		ScheduleAbilityPointFull();
 	}
+	if(ChangedMask & FighterAttributeBit(EFighterAttribute::Cooldowns))
+	{
+		UpdateReplicatedCooldowns();
+	}
+	OnAttributesChanged.Broadcast((int32)ChangedMask);
 }
+
 void AAICharacter::CollisionControl()
 {
 	collision = false;
 }
 
-void AAICharacter::FirstSkillCooldownReduction()
+double AAICharacter::GetCombatTime() const
 {
-	FTimerHandle FirstSkillReductionTimer;
-	if(FirstSkillCooldown > 0)
+	// Server time on clients too, so replicated timestamps mean the same everywhere
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World ? World->GetTimeSeconds() : 0.0;
+}
+
+void AAICharacter::SetAIAbilityPoint(float NewAIAbilityPoint)
+{
+	Attributes.SetAbilityPoint(NewAIAbilityPoint, GetCombatTime());
+}
+
+void AAICharacter::UpdateReplicatedHealth()
+{
+	if(HasAuthority() && FCombatQuantization::UpdateHealth(RepHealth, GetHealth(), MaxHealth))
 	{
-		FirstSkillCooldown -= 1;
-		GetWorldTimerManager().SetTimer(FirstSkillReductionTimer, this, &AAICharacter::FirstSkillCooldownReduction, 1.0f);
-		GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Black,TEXT("aa"));
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAICharacter, RepHealth, this);
 	}
 }
 
-void AAICharacter::SecondSkillCooldownReduction()
+void AAICharacter::UpdateReplicatedAbilityPoint()
 {
-	FTimerHandle SecondSkillReductionTimer;
-	if(SecondSkillCooldown > 0)
+	if(HasAuthority() && RepAbilityPoint.Update(Attributes.GetAbilityPointPool()))
 	{
-		SecondSkillCooldown -= 1;
-		GetWorldTimerManager().SetTimer(SecondSkillReductionTimer, this, &AAICharacter::SecondSkillCooldownReduction, 1.0f);	
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAICharacter, RepAbilityPoint, this);
 	}
-	
 }
 
-void AAICharacter::ThirdSkillCooldownReduction()
+void AAICharacter::UpdateReplicatedCooldowns()
 {
-	FTimerHandle ThirdSkillReductionTimer;
-	if(ThirdSkillCooldown > 0)
+	if(HasAuthority() && RepCooldowns.Update(Attributes.GetCooldowns()))
 	{
-		ThirdSkillCooldown -= 1;
-		GetWorldTimerManager().SetTimer(ThirdSkillReductionTimer, this, &AAICharacter::ThirdSkillCooldownReduction, 1.0f);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAICharacter, RepCooldowns, this);
 	}
-	
 }
 
-void AAICharacter::AbilityPointRestore()
+void AAICharacter::OnRep_Health()
+{
+	SetHealth(FCombatQuantization::DequantizeHealth(RepHealth, MaxHealth));
+}
+
+void AAICharacter::OnRep_AbilityPoint()
+{
+	Attributes.SetAbilityPointPool(RepAbilityPoint.ToAttribute(MaxAbilityPoint, AbilityPointRegenRate));
+}
+
+void AAICharacter::OnRep_Cooldowns()
+{
+	RepCooldowns.ApplyTo(Attributes.EditCooldowns());
+}
+
+void AAICharacter::ScheduleAbilityPointFull()
 {
-	FTimerHandle AbilityPointRestoreTimer;
-	if(GetAIAbilityPoint() < 100)
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	const bool bWasArmed = TimerManager.IsTimerActive(AbilityPointFullTimer);
+	if(!OnAbilityPointFull.IsBound())
 	{
-		SetAIAbilityPoint(GetAIAbilityPoint() + 1);
-		GetWorldTimerManager().SetTimer(AbilityPointRestoreTimer, this, &AAICharacter::AbilityPointRestore, 0.3f);
+		TimerManager.ClearTimer(AbilityPointFullTimer);
 	}
 	else
 	{
-		AbilityPointRestoreTrigger();
+		const double Now = GetCombatTime();
+		const double FullTime = Attributes.GetAbilityPointPool().GetFullTime(Now);
+		if(FullTime > Now && FullTime < FRegeneratingAttribute::NeverFull)
+		{
+			TimerManager.SetTimer(AbilityPointFullTimer, this, &AAICharacter::BroadcastAbilityPointFull, (float)(FullTime - Now));
+		}
 	}
+	FBossFightStats::AddActiveTimers((int32)TimerManager.IsTimerActive(AbilityPointFullTimer) - (int32)bWasArmed);
 }
 
-void AAICharacter::AbilityPointRestoreTrigger()
+void AAICharacter::BroadcastAbilityPointFull()
 {
-	FTimerHandle AbilityPointTriggerTimer;
-	GetWorldTimerManager().SetTimer(AbilityPointTriggerTimer, this, &AAICharacter::AbilityPointRestore, 0.1f);
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_BossAbilityPointFull);
+	FBossFightStats::AddActiveTimers(-1);
+	COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::AbilityPointFull, GetAIAbilityPoint());
+	OnAbilityPointFull.Broadcast();
 }
 
+float AAICharacter::GetFirstSkillCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::FirstSkill, GetCombatTime());
+}
 
+float AAICharacter::GetSecondSkillCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::SecondSkill, GetCombatTime());
+}
 
-
-
-
-
-
-
-
-
-
-
-
+float AAICharacter::GetThirdSkillCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::ThirdSkill, GetCombatTime());
+}
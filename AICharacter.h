@@ -4,11 +4,23 @@
 #include "AIController.h"
 #include "CoreMinimal.h"
 #include "BossFightCharacter.h"
+#include "FighterAttributes.h"
+#include "SkillDefinition.h"
+#include "CombatReplication.h"
 #include "GameFramework/Character.h"
 #include "AICharacter.generated.h"
 
 
-class UPawnSensingComponent;
+class USkillTableAsset;
+class UBossBrainSubsystem;
+class UBossPerceptionSubsystem;
+class URoamQuerySubsystem;
+class UPursuitSubsystem;
+class UThreatSubsystem;
+class UStatusEffectSubsystem;
+class UCombatDamageSubsystem;
+class UMeleeReachSubsystem;
+enum class EBossLOD : uint8;
 
 UCLASS()
 class BOSSFIGHT_API AAICharacter : public ACharacter
@@ -19,43 +31,126 @@ public:
 	// Sets default values for this character's properties
 	AAICharacter();
 
-	void FirstSkill();
-	void SecondSkill();
-	void ThirdSkill();
-	void BasicHit();
-    
-	void FirstSkillCooldownReduction();
-	void SecondSkillCooldownReduction();
-	void ThirdSkillCooldownReduction();
-	
-    void AbilityPointRestore();
-	void AbilityPointRestoreTrigger();
+	/** Lands a skill of the skill table on the player once its wind-up is over */
+	void ExecuteSkill(int32 SkillId);
+
+	/** Skills of the boss, the built-in defaults are used when not set */
+	UPROPERTY(EditDefaultsOnly, Category = "Skill")
+	USkillTableAsset* SkillTableAsset;
+
+	/** TSkillExecutor interface */
+	FORCEINLINE float GetSkillResource() const { return GetAIAbilityPoint(); }
+	FORCEINLINE void SpendSkillResource(float Amount) { Attributes.AddAbilityPoint(-Amount, GetCombatTime()); }
+	void ApplySkillDamage(float Damage);
+	FORCEINLINE FCooldownTracker& GetCooldowns() { return Attributes.EditCooldowns(); }
+	FORCEINLINE const FCooldownTracker& GetCooldowns() const { return Attributes.GetCooldowns(); }
+	FORCEINLINE const FSkillTable& GetSkillTable() const { return SkillTable; }
+
+	/** Broadcast when ability points reach the cap. A timer is only armed while something is bound. */
+	UPROPERTY(BlueprintAssignable, Category = "AbilityPoint")
+	FOnAbilityPointFull OnAbilityPointFull;
+	void BroadcastAbilityPointFull();
+
+	/** Broadcast once when health drops to zero, the boss goes back to the fighter pool afterwards */
+	UPROPERTY(BlueprintAssignable, Category = "Health")
+	FOnFighterDeath OnDeath;
+	void HandleDeath();
+
+	/** Broadcast once per frame at most, after the attributes changed */
+	UPROPERTY(BlueprintAssignable, Category = "Attributes")
+	FOnFighterAttributesChanged OnAttributesChanged;
+	/** Called by UCombatDamageSubsystem once per frame with the attributes that changed, feeds replication and the UI */
+	void HandleAttributesChanged(uint32 ChangedMask);
 	UFUNCTION()
 	    void CollisionControl();
-    UFUNCTION()
-	    void KillMainCharacter();
 	UFUNCTION()
 		void NewMovement();
+	/** Receives the roam target requested by NewMovement, ignored if a newer move was issued meanwhile */
+	void OnRoamPointReady(bool bSuccess, const FVector& Location, uint32 RequestId);
 	UFUNCTION()
 		void SeePawn(APawn* Pawn);
 	UFUNCTION()
 		void OnHearNoise(APawn* OtherActor, const FVector& Location, float Volume);
-	UFUNCTION()
-		void BeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	/** Called by UBossPerceptionSubsystem when the boss senses the player it chases again, only pushes the chase on */
+	void KeepPursuing();
+	FORCEINLINE bool IsPursuing() const { return PursuitIndex != INDEX_NONE; }
+	/** Called by UBossPerceptionSubsystem when the boss changes tier, scales its tick and roam rates */
+	void SetLOD(EBossLOD NewLOD);
+	/** Called by UMeleeReachSubsystem when a player comes within MeleeReach, engages it unless already engaged */
+	void OnMeleeContactBegin(ABossFightCharacter* Player);
+	/** Called by UMeleeReachSubsystem when a player in reach leaves the fight, the pending skill no longer lands on it */
+	void OnPlayerLeft(const ABossFightCharacter* Player);
 
-	UPROPERTY(VisibleDefaultsOnly, Category = "Components")
-	UPawnSensingComponent* PawnSensing;
+	/** Sensing settings, read by UBossPerceptionSubsystem when the boss registers */
+	UPROPERTY(EditDefaultsOnly, Category = "Perception")
+	float SightRadius;
+	/** Half angle of the field of view in degrees */
+	UPROPERTY(EditDefaultsOnly, Category = "Perception")
+	float PeripheralVisionAngle;
+	/** Noises are heard within this range times their loudness */
+	UPROPERTY(EditDefaultsOnly, Category = "Perception")
+	float HearingThreshold;
+	/** Noises are heard within this range times their loudness when in line of sight */
+	UPROPERTY(EditDefaultsOnly, Category = "Perception")
+	float LOSHearingThreshold;
+	/** Seconds between two sight checks */
+	UPROPERTY(EditDefaultsOnly, Category = "Perception")
+	float SensingInterval;
+	UPROPERTY()
+	UBossPerceptionSubsystem* Perception;
+	/** Index of this boss in the perception subsystem, INDEX_NONE when not registered */
+	int32 PerceptionIndex;
 	UPROPERTY()
 	AAIController* AIC_Ref;
+	/** Batch that drives roaming and skill wind-ups of this boss */
+	UPROPERTY()
+	UBossBrainSubsystem* Brain;
+	/** Index of this boss in the brain subsystem, INDEX_NONE when not registered */
+	int32 BrainIndex;
+	/** Batched source of roam targets */
+	UPROPERTY()
+	URoamQuerySubsystem* RoamQueries;
+	/** Steers the boss toward the player it chases */
+	UPROPERTY()
+	UPursuitSubsystem* Pursuit;
+	/** Index of this boss in the pursuit subsystem, INDEX_NONE when not chasing anyone */
+	int32 PursuitIndex;
+	/** Seconds a boss keeps chasing a player after it last sensed it, roaming resumes afterwards */
+	static constexpr float PursuitDuration = 2.f;
+	/** Walk speed while chasing, a MoveSpeed effect that ends with the pursuit */
+	static constexpr float ChaseSpeed = 700.f;
+	/** Buffs and debuffs of this boss, the chase speed among them */
+	UPROPERTY()
+	UStatusEffectSubsystem* StatusEffects;
+	/** Keeps who the boss hates most, its skills land on that player */
+	UPROPERTY()
+	UThreatSubsystem* Threat;
+	/** Index of this boss in the threat subsystem, INDEX_NONE when not registered */
+	int32 ThreatIndex;
+	/** Applies the damage of the skills of this boss and owns its health */
+	UPROPERTY()
+	UCombatDamageSubsystem* DamageQueue;
+	/** Index of this boss in the damage subsystem, INDEX_NONE when not registered */
+	int32 DamageIndex;
+	/** Bumped on every move order so late roam results can be told apart */
+	uint32 MoveRequestId;
+	/** Players closer than this are in melee contact */
+	UPROPERTY(EditDefaultsOnly, Category = "Melee")
+	float MeleeReach;
 	UPROPERTY()
-	FTimerHandle Timer;
+	UMeleeReachSubsystem* MeleeReachSystem;
+	/** Index of this boss in the melee reach subsystem, INDEX_NONE when not registered */
+	int32 MeleeIndex;
+	/** Player the pending skill lands on: the one that engaged the boss, replaced by the top of the threat table on cast */
 	UPROPERTY()
-	FTimerHandle Skills;
-	UPROPERTY(EditDefaultsOnly)
-	class UCapsuleComponent* AICharacterCompCapsule;
 	ABossFightCharacter*MainCharacter;
+	/** True from engaging a player until the skill landed */
 	bool collision;
 
+	/** Called by UFighterPoolSubsystem: a pooled boss leaves every batch, an unpooled one rejoins them reset */
+	void SetInPool(bool bNewInPool);
+	FORCEINLINE bool IsInPool() const { return bInPool; }
+
 	
 	
 	
@@ -63,29 +158,85 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void UnPossessed() override;
+
+public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	/** Remaining cooldowns in seconds, 0 when ready */
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetFirstSkillCooldown() const;
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetSecondSkillCooldown() const;
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetThirdSkillCooldown() const;
 
 private:
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int FirstSkillCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int SecondSkillCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int ThirdSkillCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	float AIAttack = 10;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	float AIAbilityPoint = 100;
+	/** World time used for cooldowns and regeneration */
+	double GetCombatTime() const;
+	/** Speeds the boss up to ChaseSpeed for PursuitDuration, or keeps it there for that long */
+	void ApplyChaseSpeed();
+	/** Arms the "AP full" timer if a listener is bound, clears it otherwise */
+	void ScheduleAbilityPointFull();
+	/** Resets the combat state to the defaults and registers with the batches, on spawn and when leaving the pool */
+	void JoinCombat();
+	/** Unregisters from the batches and stops, on EndPlay and when entering the pool */
+	void LeaveCombat();
+
+	/** Server only: copy the attributes to their replicated forms and mark the ones that changed dirty */
+	void UpdateReplicatedHealth();
+	void UpdateReplicatedAbilityPoint();
+	void UpdateReplicatedCooldowns();
+
+	UFUNCTION()
+	void OnRep_Health();
+	UFUNCTION()
+	void OnRep_AbilityPoint();
+	UFUNCTION()
+	void OnRep_Cooldowns();
+	UFUNCTION()
+	void OnRep_InPool();
+
+	/** Quantized Health */
+	UPROPERTY(ReplicatedUsing = OnRep_Health)
+	uint16 RepHealth;
+	UPROPERTY(ReplicatedUsing = OnRep_AbilityPoint)
+	FRepRegeneratingAttribute RepAbilityPoint;
+	UPROPERTY(ReplicatedUsing = OnRep_Cooldowns)
+	FRepCooldowns RepCooldowns;
+	/** Hidden in UFighterPoolSubsystem, out of every batch */
+	UPROPERTY(ReplicatedUsing = OnRep_InPool)
+	bool bInPool;
+
+	FFighterAttributes Attributes;
+	FSkillTable SkillTable;
+	FTimerHandle AbilityPointFullTimer;
+	/** Starting and maximum health, the range RepHealth is quantized to */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float MaxHealth = FFighterDefaults::BossMaxHealth;
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float Attack = 10;
+	/** Starting and maximum ability points */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float MaxAbilityPoint = FFighterDefaults::MaxAbilityPoint;
+	/** Ability points regenerated per second */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float AbilityPointRegenRate = FFighterDefaults::AbilityPointRegenRate;
 public:
-	
-	FORCEINLINE void SetAIAttack(float AINewAttack) { AIAttack = AINewAttack; }
-	FORCEINLINE float GetAIAttack() { return AIAttack; }
+	FORCEINLINE const FFighterAttributes& GetAttributes() const { return Attributes; }
+
+	void SetHealth(float NewHealth);
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetHealth() const { return Attributes.GetHealth(); }
+
+	FORCEINLINE void SetAIAttack(float AINewAttack) { Attributes.SetAttack(AINewAttack); }
+	FORCEINLINE float GetAIAttack() const { return Attributes.GetAttack(); }
 
-	FORCEINLINE void SetAIAbilityPoint(float NewAIAbilityPoint) { AIAbilityPoint = NewAIAbilityPoint ;}
-	FORCEINLINE float GetAIAbilityPoint() {return AIAbilityPoint; }
+	void SetAIAbilityPoint(float NewAIAbilityPoint);
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetAIAbilityPoint() const { return Attributes.GetAbilityPoint(GetCombatTime()); }
 
 	
 
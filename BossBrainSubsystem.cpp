@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BossBrainSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightStats.h"
+#include "SkillExecutor.h"
+#include "FightRecorder.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	int32 GBossFightSeed = 0;
+	FAutoConsoleVariableRef CVarBossFightSeed(
+		TEXT("BossFight.Seed"),
+		GBossFightSeed,
+		TEXT("Seed of the boss skill choices, read when a world starts. 0 picks one at random, which is logged."));
+}
+
+void UBossBrainSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SetSeed(GBossFightSeed != 0 ? (uint64)(uint32)GBossFightSeed : (uint64)FPlatformTime::Cycles64());
+	UE_LOG(LogTemp, Log, TEXT("Boss brain seed %llu, set BossFight.Seed to replay it"), Seed);
+}
+
+void UBossBrainSubsystem::Deinitialize()
+{
+	FFightRecorder::EndWorld(*GetWorld());
+
+	Super::Deinitialize();
+}
+
+void UBossBrainSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	FFightRecorder::BeginWorld(InWorld, Seed);
+}
+
+void UBossBrainSubsystem::SetSeed(uint64 NewSeed)
+{
+	Seed = NewSeed;
+	NumRegistrations = 0;
+	FIGHT_RECORD(EFightRecordType::Seed, GetWorld()->GetTimeSeconds(), Seed);
+}
+
+int32 UBossBrainSubsystem::RegisterBoss(AAICharacter* Boss, double FirstRoamTime)
+{
+	check(Boss);
+	const int32 BossIndex = Bosses.Add(Boss);
+	NextRoamTimes.Add(FirstRoamTime);
+	RoamIntervals.Add(RoamInterval);
+	PendingSkills.Add(INDEX_NONE);
+	SkillImpactTimes.Add(0.0);
+	DecisionTimes.Add(-1.0);
+	FIGHT_RECORD(EFightRecordType::BossJoined, GetWorld()->GetTimeSeconds(), Boss->GetUniqueID(), NumRegistrations);
+	RandomStreams.Add(FCombatRandom::ForStream(Seed, NumRegistrations++));
+	Boss->BrainIndex = BossIndex;
+	return BossIndex;
+}
+
+void UBossBrainSubsystem::UnregisterBoss(AAICharacter* Boss)
+{
+	const int32 BossIndex = Boss ? Boss->BrainIndex : INDEX_NONE;
+	if (!Bosses.IsValidIndex(BossIndex) || Bosses[BossIndex] != Boss)
+	{
+		return;
+	}
+
+	FIGHT_RECORD(EFightRecordType::Left, GetWorld()->GetTimeSeconds(), Boss->GetUniqueID());
+	Bosses.RemoveAtSwap(BossIndex, 1, false);
+	NextRoamTimes.RemoveAtSwap(BossIndex, 1, false);
+	RoamIntervals.RemoveAtSwap(BossIndex, 1, false);
+	PendingSkills.RemoveAtSwap(BossIndex, 1, false);
+	SkillImpactTimes.RemoveAtSwap(BossIndex, 1, false);
+	DecisionTimes.RemoveAtSwap(BossIndex, 1, false);
+	RandomStreams.RemoveAtSwap(BossIndex, 1, false);
+	if (Bosses.IsValidIndex(BossIndex))
+	{
+		Bosses[BossIndex]->BrainIndex = BossIndex;
+	}
+	Boss->BrainIndex = INDEX_NONE;
+}
+
+void UBossBrainSubsystem::ScheduleRoam(int32 BossIndex, double RoamTime)
+{
+	if (NextRoamTimes.IsValidIndex(BossIndex))
+	{
+		NextRoamTimes[BossIndex] = RoamTime;
+	}
+}
+
+void UBossBrainSubsystem::SetRoamInterval(int32 BossIndex, float Interval)
+{
+	if (RoamIntervals.IsValidIndex(BossIndex))
+	{
+		RoamIntervals[BossIndex] = Interval;
+	}
+}
+
+void UBossBrainSubsystem::ScheduleSkill(int32 BossIndex, int32 SkillId, double ImpactTime)
+{
+	if (PendingSkills.IsValidIndex(BossIndex))
+	{
+		PendingSkills[BossIndex] = SkillId;
+		SkillImpactTimes[BossIndex] = ImpactTime;
+	}
+}
+
+void UBossBrainSubsystem::CancelSkill(int32 BossIndex)
+{
+	if (PendingSkills.IsValidIndex(BossIndex))
+	{
+		PendingSkills[BossIndex] = INDEX_NONE;
+	}
+}
+
+void UBossBrainSubsystem::RequestDecision(int32 BossIndex, double DecisionTime)
+{
+	if (DecisionTimes.IsValidIndex(BossIndex))
+	{
+		DecisionTimes[BossIndex] = DecisionTime;
+	}
+}
+
+void UBossBrainSubsystem::RunDecisions()
+{
+	ParallelFor(Decisions.Num(), [this](int32 DecisionIndex)
+	{
+		FDecision& Decision = Decisions[DecisionIndex];
+		const FSkillTable& SkillTable = *Decision.SkillTable;
+		const int32 Roll = RandomStreams[Decision.BossIndex].RandRange(0, SkillTable.Num() - 1);
+		Decision.SkillId = TSkillExecutor<FDecision>::ChooseSkill(Decision, SkillTable, Roll, Decision.Time);
+	}, Decisions.Num() < MinParallelDecisions);
+}
+
+void UBossBrainSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UBossBrainSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	FBossFightStats::Update(Now);
+
+	const int32 NumBossesToUpdate = Bosses.Num();
+	if (NumBossesToUpdate == 0)
+	{
+		return;
+	}
+
+	// Gather everything that is due first, the callbacks below may register or unregister bosses
+	DueRoams.Reset();
+	DueSkills.Reset();
+	Decisions.Reset();
+	for (int32 BossIndex = 0; BossIndex < NumBossesToUpdate; BossIndex++)
+	{
+		if (DecisionTimes[BossIndex] >= 0.0)
+		{
+			const AAICharacter* Boss = Bosses[BossIndex];
+			const double DecisionTime = DecisionTimes[BossIndex];
+			// Ability points as of the decision time, like the cooldowns, so a late frame picks what a replay picks
+			Decisions.Add({ &Boss->GetSkillTable(), Boss->GetCooldowns(), Boss->GetAttributes().GetAbilityPoint(DecisionTime), DecisionTime, BossIndex, INDEX_NONE });
+			DecisionTimes[BossIndex] = -1.0;
+		}
+		if (Now >= NextRoamTimes[BossIndex])
+		{
+			NextRoamTimes[BossIndex] = Now + RoamIntervals[BossIndex];
+			DueRoams.Add(Bosses[BossIndex]);
+		}
+		if (PendingSkills[BossIndex] != INDEX_NONE && Now >= SkillImpactTimes[BossIndex])
+		{
+			DueSkills.Emplace(Bosses[BossIndex], PendingSkills[BossIndex]);
+			PendingSkills[BossIndex] = INDEX_NONE;
+		}
+	}
+
+	// Decide in parallel, then schedule the chosen skills here, before any callback can move the bosses around
+	if (Decisions.Num() > 0)
+	{
+		RunDecisions();
+		for (const FDecision& Decision : Decisions)
+		{
+			if (Decision.SkillTable->IsValidSkill(Decision.SkillId))
+			{
+				ScheduleSkill(Decision.BossIndex, Decision.SkillId, Decision.Time + (*Decision.SkillTable)[Decision.SkillId].WindUp);
+			}
+		}
+	}
+
+	for (AAICharacter* Boss : DueRoams)
+	{
+		if (IsValid(Boss))
+		{
+			Boss->NewMovement();
+		}
+	}
+	for (const TPair<AAICharacter*, int32>& DueSkill : DueSkills)
+	{
+		if (IsValid(DueSkill.Key))
+		{
+			DueSkill.Key->ExecuteSkill(DueSkill.Value);
+		}
+	}
+}
+
+TStatId UBossBrainSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_BrainTick);
+}
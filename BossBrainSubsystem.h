@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRules.h"
+#include "SkillDefinition.h"
+#include "BossBrainSubsystem.generated.h"
+
+class AAICharacter;
+
+/**
+ * Owns the timing state of every boss of the world and advances all of them in one pass per frame.
+ * Bosses neither tick nor own timers: roaming and skill wind-ups are due times stored here.
+ * Skill choices run as one parallel decision phase over snapshots of the bosses, each boss rolling its own random
+ * stream derived from the world seed, so a fight plays the same for a seed whatever the thread count.
+ */
+UCLASS()
+class BOSSFIGHT_API UBossBrainSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Seconds between two roam targets at full rate */
+	static constexpr float RoamInterval = 3.f;
+	/** Below this many decisions in a frame the decision phase stays on the game thread */
+	static constexpr int32 MinParallelDecisions = 16;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** Starts the fight recording of the world, see FFightRecorder */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Adds a boss to the batch and returns its index */
+	int32 RegisterBoss(AAICharacter* Boss, double FirstRoamTime);
+	void UnregisterBoss(AAICharacter* Boss);
+
+	/** Moves the next roam of a boss to the given time */
+	void ScheduleRoam(int32 BossIndex, double RoamTime);
+	/** Seconds between two roam targets of a boss from its next roam on */
+	void SetRoamInterval(int32 BossIndex, float Interval);
+	/** Lands SkillId of a boss at the given time, replacing any pending skill */
+	void ScheduleSkill(int32 BossIndex, int32 SkillId, double ImpactTime);
+	void CancelSkill(int32 BossIndex);
+	/** Has a boss pick its next skill in the next decision phase, the wind-up counts from DecisionTime */
+	void RequestDecision(int32 BossIndex, double DecisionTime);
+
+	/**
+	 * Seed the random streams of the bosses derive from, taken from BossFight.Seed or picked at random.
+	 * Bosses registered afterwards, in the same order, roll the same skills.
+	 */
+	void SetSeed(uint64 NewSeed);
+	FORCEINLINE uint64 GetSeed() const { return Seed; }
+
+	FORCEINLINE int32 NumBosses() const { return Bosses.Num(); }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Read-only copy of what a skill choice depends on, implements the const part of the TSkillExecutor interface */
+	struct FDecision
+	{
+		const FSkillTable* SkillTable;
+		FCooldownTracker Cooldowns;
+		float AbilityPoint;
+		double Time;
+		int32 BossIndex;
+		/** Result of the decision phase */
+		int32 SkillId;
+
+		FORCEINLINE float GetSkillResource() const { return AbilityPoint; }
+		FORCEINLINE const FCooldownTracker& GetCooldowns() const { return Cooldowns; }
+	};
+
+	/** Rolls the skills of the gathered decisions, each one only touches its own boss stream */
+	void RunDecisions();
+
+	UPROPERTY()
+	TArray<AAICharacter*> Bosses;
+	/** World time of the next roam of each boss */
+	TArray<double> NextRoamTimes;
+	TArray<float> RoamIntervals;
+	/** Skill waiting for its wind-up, INDEX_NONE when idle */
+	TArray<int32> PendingSkills;
+	TArray<double> SkillImpactTimes;
+	/** Time a skill choice was requested at, negative when none is */
+	TArray<double> DecisionTimes;
+	TArray<FCombatRandom> RandomStreams;
+
+	uint64 Seed;
+	/** Bosses registered since the seed was set, gives each one its own stream */
+	uint64 NumRegistrations;
+
+	/** Scratch lists of the bosses due this frame, kept to avoid reallocating */
+	TArray<AAICharacter*> DueRoams;
+	TArray<TPair<AAICharacter*, int32>> DueSkills;
+	TArray<FDecision> Decisions;
+};
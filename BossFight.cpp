@@ -2,6 +2,24 @@
 
 #include "BossFight.h"
 #include "Modules/ModuleManager.h"
+#include "CombatEventLogDebug.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, BossFight, "BossFight" );
- 
\ No newline at end of file
+class FBossFightModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+#if COMBAT_EVENT_LOG_ENABLED
+		FCombatEventLogDebug::Register();
+#endif
+	}
+
+	virtual void ShutdownModule() override
+	{
+#if COMBAT_EVENT_LOG_ENABLED
+		FCombatEventLogDebug::Unregister();
+#endif
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FBossFightModule, BossFight, "BossFight" );
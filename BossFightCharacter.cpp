@@ -6,9 +6,30 @@
 #include "Components/InputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "AICharacter.h"
+#include "SkillExecutor.h"
+#include "SkillTableAsset.h"
+#include "BossPerceptionSubsystem.h"
+#include "CombatDamageSubsystem.h"
+#include "MeleeReachSubsystem.h"
+#include "ThreatSubsystem.h"
+#include "StatusEffectSubsystem.h"
+#include "FighterPoolSubsystem.h"
+#include "StartupLoadSubsystem.h"
+#include "FightRecorder.h"
+#include "BossFightStats.h"
+#include "CombatEventLog.h"
 #include "GameFramework/SpringArmComponent.h"
 
+namespace
+{
+	/** Input actions of the default player skills, in skill id order */
+	const FName GDefaultSkillInputActions[] = { TEXT("FirstSkill"), TEXT("SecondSkill"), TEXT("ThirdSkill"), TEXT("BasicAttack") };
+}
+
 //////////////////////////////////////////////////////////////////////////
 // ABossFightCharacter
 
@@ -51,34 +72,188 @@ ABossFightCharacter::ABossFightCharacter()
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 
-	BossFightCharacterCompCapsule = CreateDefaultSubobject<UCapsuleComponent>(TEXT("BossFightCharacterCompCapsuleCpp"));
-	BossFightCharacterCompCapsule->SetupAttachment(GetRootComponent());
+	Completed = true;
+	MeleeContacts = 0;
+	PerceptionIndex = INDEX_NONE;
+	DamageIndex = INDEX_NONE;
+	RepHealth = 0;
+	NextPredictionKey = 1;
+	bInPool = false;
+
+	AbilityPointPotionPiece = FFighterDefaults::PotionCharges;
+	HealthPotionPiece = FFighterDefaults::PotionCharges;
+}
+
+void ABossFightCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	MeleeReachSystem = GetWorld()->GetSubsystem<UMeleeReachSubsystem>();
+
+	if (SkillTableAsset)
+	{
+		SkillTableAsset->BuildTable(SkillTable);
+	}
+	else
+	{
+		SkillTable.Assign(GPlayerDefaultSkills);
+	}
+
+	DamageQueue = GetWorld()->GetSubsystem<UCombatDamageSubsystem>();
+	if (HasAuthority())
+	{
+		Threat = GetWorld()->GetSubsystem<UThreatSubsystem>();
+		StatusEffects = GetWorld()->GetSubsystem<UStatusEffectSubsystem>();
+	}
+
+	// Pooled pawns join when they are taken out of the pool
+	if (!bInPool)
+	{
+		JoinCombat();
+	}
+}
+
+void ABossFightCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (!bInPool)
+	{
+		LeaveCombat();
+	}
 
-	collision = false;
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABossFightCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	if (UStartupLoadSubsystem* StartupLoads = GetWorld()->GetSubsystem<UStartupLoadSubsystem>())
+	{
+		StartupLoads->NotePlayable();
+	}
+}
+
+void ABossFightCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	if (UStartupLoadSubsystem* StartupLoads = GetWorld()->GetSubsystem<UStartupLoadSubsystem>())
+	{
+		StartupLoads->NotePlayable();
+	}
+}
+
+void ABossFightCharacter::JoinCombat()
+{
+	// Every attribute starts dirty, the first publish replicates all of them
+	Attributes = FFighterAttributes(MaxHealth, Attack, MaxAbilityPoint, AbilityPointRegenRate, HealthPotionPiece, AbilityPointPotionPiece, GetCombatTime());
+	PredictedSkills.Reset();
 	Completed = true;
+	MeleeContacts = 0;
+	EngagedBoss = nullptr;
 
-	FirstSkillCooldown = 0;
-	SecondSkillCooldown = 0;
-	ThirdSkillCooldown = 0;
+	GetWorld()->GetSubsystem<UBossPerceptionSubsystem>()->RegisterPlayer(this);
 
-	AbilityPointPotion = 30;
-	HealthPotion = 50;
+	DamageIndex = DamageQueue->RegisterTarget(this, &Attributes, FSimpleDelegate::CreateUObject(this, &ABossFightCharacter::HandleDeath),
+		FOnAttributesChanged::CreateUObject(this, &ABossFightCharacter::HandleAttributesChanged));
+
+	if (HasAuthority())
+	{
+		FIGHT_RECORD(EFightRecordType::PlayerJoined, GetCombatTime(), GetUniqueID());
+		if (FFightRecorder::IsRecording())
+		{
+			FFightRecorder::RecordFighter(GetCombatTime(), GetUniqueID(), Attributes, SkillTable);
+		}
+	}
+	else
+	{
+		// The replicated state may arrive before BeginPlay or before leaving the pool, apply it over the defaults set above
+		OnRep_Health();
+		if (GetLocalRole() == ROLE_AutonomousProxy)
+		{
+			RebuildPredictedState();
+		}
+	}
+}
 
-	AbilityPointPotionPiece = 5;
-	HealthPotionPiece = 5;
+void ABossFightCharacter::LeaveCombat()
+{
+	if (HasAuthority())
+	{
+		FIGHT_RECORD(EFightRecordType::Left, GetCombatTime(), GetUniqueID());
+	}
+	if (UBossPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UBossPerceptionSubsystem>())
+	{
+		Perception->UnregisterPlayer(this);
+	}
+	if (MeleeReachSystem)
+	{
+		MeleeReachSystem->RemovePlayer(this);
+	}
+	MeleeContacts = 0;
+	EngagedBoss = nullptr;
+	// The tables know the player by its damage index, which is reused once it is unregistered
+	if (Threat)
+	{
+		Threat->RemovePlayer(this);
+	}
+	if (StatusEffects)
+	{
+		StatusEffects->RemoveTarget(DamageIndex);
+	}
+	if (DamageQueue)
+	{
+		DamageQueue->UnregisterTarget(DamageIndex);
+		DamageIndex = INDEX_NONE;
+	}
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	FBossFightStats::AddActiveTimers(-((int32)TimerManager.IsTimerActive(AbilityPointFullTimer) + (int32)TimerManager.IsTimerActive(WindUpTimer)));
+	TimerManager.ClearTimer(AbilityPointFullTimer);
+	TimerManager.ClearTimer(WindUpTimer);
+}
 
-	AbilityPointPotionCooldown = 0;
-	HealthPotionCooldown = 0;
+void ABossFightCharacter::SetInPool(bool bNewInPool)
+{
+	if (bInPool == bNewInPool)
+	{
+		return;
+	}
+	bInPool = bNewInPool;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ABossFightCharacter, bInPool, this);
+	OnRep_InPool();
 }
 
-void ABossFightCharacter::BeginPlay()
+void ABossFightCharacter::OnRep_InPool()
 {
-	Super::BeginPlay();
+	// Before BeginPlay the flag only decides whether BeginPlay joins
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+	if (bInPool)
+	{
+		LeaveCombat();
+	}
+	else
+	{
+		JoinCombat();
+	}
+}
 
-	BossFightCharacterCompCapsule->OnComponentBeginOverlap.AddDynamic(this, &ABossFightCharacter::BeginOverlap);
-	BossFightCharacterCompCapsule->OnComponentEndOverlap.AddDynamic(this, &ABossFightCharacter::OnOverlapEnd);
-	
-	AbilityPointRestoreTrigger();
+void ABossFightCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABossFightCharacter, RepHealth, SharedParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABossFightCharacter, bInPool, SharedParams);
+
+	FDoRepLifetimeParams OwnerParams;
+	OwnerParams.bIsPushBased = true;
+	OwnerParams.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABossFightCharacter, RepAbilityPoint, OwnerParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABossFightCharacter, RepCooldowns, OwnerParams);
 }
 
 
@@ -94,10 +269,24 @@ void ABossFightCharacter::SetupPlayerInputComponent(class UInputComponent* Playe
 	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
 	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
 
-	PlayerInputComponent->BindAction("FirstSkill", IE_Pressed, this, &ABossFightCharacter::FirstSkill);
-	PlayerInputComponent->BindAction("SecondSkill", IE_Pressed, this, &ABossFightCharacter::SecondSkill);
-	PlayerInputComponent->BindAction("ThirdSkill", IE_Pressed, this, &ABossFightCharacter::ThirdSkill);
-	PlayerInputComponent->BindAction("BasicAttack", IE_Pressed, this, &ABossFightCharacter::BasicAttack);
+	if (SkillTableAsset)
+	{
+		for (int32 SkillId = 0; SkillId < SkillTableAsset->Skills.Num(); SkillId++)
+		{
+			const FName InputAction = SkillTableAsset->Skills[SkillId].InputAction;
+			if (!InputAction.IsNone())
+			{
+				PlayerInputComponent->BindAction<FUseSkillDelegate>(InputAction, IE_Pressed, this, &ABossFightCharacter::UseSkill, SkillId);
+			}
+		}
+	}
+	else
+	{
+		for (int32 SkillId = 0; SkillId < (int32)UE_ARRAY_COUNT(GDefaultSkillInputActions); SkillId++)
+		{
+			PlayerInputComponent->BindAction<FUseSkillDelegate>(GDefaultSkillInputActions[SkillId], IE_Pressed, this, &ABossFightCharacter::UseSkill, SkillId);
+		}
+	}
 
 	PlayerInputComponent->BindAction("HealthPotion", IE_Pressed, this, &ABossFightCharacter::UseHealthPotion);
 	PlayerInputComponent->BindAction("AbilityPointPotion", IE_Pressed, this, &ABossFightCharacter::UseAbilityPointPotion);
@@ -170,223 +359,373 @@ void ABossFightCharacter::MoveRight(float Value)
 	}
 }
 
-void ABossFightCharacter::BeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void ABossFightCharacter::OnMeleeContactBegin(AAICharacter* Boss)
 {
-	AAICharacter* Carp1 = Cast<AAICharacter>(OtherActor);	
-	if(Carp1 && collision == false)
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerContactBegin);
+	if(MeleeContacts++ == 0)
 	{
-		
-		collision = true;
-		GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Red,TEXT("asda"));		
+		EngagedBoss = Boss;
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::OverlapBegin);
 	}
 }
 
-void ABossFightCharacter::OnOverlapEnd(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void ABossFightCharacter::OnMeleeContactEnd(AAICharacter* Boss)
 {
-	collision = false;
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerContactEnd);
+	MeleeContacts = FMath::Max(MeleeContacts - 1, 0);
+	if(MeleeContacts == 0)
+	{
+		EngagedBoss = nullptr;
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::OverlapEnd);
+	}
+	else if(EngagedBoss.Get() == Boss)
+	{
+		EngagedBoss = MeleeReachSystem->FindBossInReach(this);
+	}
 }
 
 
-void ABossFightCharacter::FirstSkill()
+void ABossFightCharacter::UseSkill(int32 SkillId)
 {
-	FTimerHandle FirstSkillTimer;
-	if(collision == true && FirstSkillCooldown <= 0 && Completed == true)
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerUseSkill);
+	if(HasAuthority())
 	{
-		
-		if(GetAbilityPoint() >= 20)
-		{
-			GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Cyan,TEXT("1.Yetenek Kullanildi"));
-			SetAbilityPoint(GetAbilityPoint() - 20);
-			SetAIHealth(GetAIHealth() - 20);
-			FirstSkillCooldown = 6;
-			Completed = false;
-			FirstSkillCooldownReduction();
-			GetWorldTimerManager().SetTimer(FirstSkillTimer, this, &ABossFightCharacter::CompletedControl, 1.2f);	
-		}
-		
+		TryActivateSkill(SkillId, 0.f);
+		return;
+	}
+
+	const double Now = GetCombatTime();
+	if(!CanUseSkill(SkillId, Now, 0.f))
+	{
+		return;
 	}
+	if(PredictedSkills.Num() >= MaxPredictedSkills)
+	{
+		ServerUseSkill(SkillId, 0);
+		return;
+	}
+
+	const uint16 Key = NextPredictionKey;
+	NextPredictionKey = NextPredictionKey == MAX_uint16 ? 1 : NextPredictionKey + 1;
+	const FPredictedSkill& Prediction = PredictedSkills.Add_GetRef({ Key, SkillId, Now });
+	ApplyPredictedSkill(Prediction);
+	StartWindUp(SkillTable[SkillId].WindUp);
+	COMBAT_LOG_EVENT(Now, GetUniqueID(), ECombatEventType::SkillCast, (float)SkillId, 0.f);
+	ServerUseSkill(SkillId, Key);
 }
 
-void ABossFightCharacter::SecondSkill()
+void ABossFightCharacter::ServerUseSkill_Implementation(int32 SkillId, uint16 PredictionKey)
 {
-	FTimerHandle SecondSkillTimer;
-	if(collision == true && SecondSkillCooldown <= 0 && Completed == true)
+	const bool bActivated = TryActivateSkill(SkillId, PredictionKey != 0 ? SkillPredictionTolerance : 0.f);
+	if(PredictionKey != 0)
 	{
-		
-		if(GetAbilityPoint() >= 30)
+		ClientAckSkill(PredictionKey, bActivated);
+	}
+}
+
+void ABossFightCharacter::ClientAckSkill_Implementation(uint16 PredictionKey, bool bAccepted)
+{
+	const int32 PredictionIndex = PredictedSkills.IndexOfByPredicate([PredictionKey](const FPredictedSkill& Prediction) { return Prediction.Key == PredictionKey; });
+	if(PredictionIndex == INDEX_NONE)
+	{
+		return;
+	}
+	PredictedSkills.RemoveAt(PredictionIndex);
+
+	// The replicated state may already hold an accepted skill, reapplying its prediction on top would count it twice
+	RebuildPredictedState();
+	if(!bAccepted)
+	{
+		if(GetWorldTimerManager().IsTimerActive(WindUpTimer))
 		{
-			GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Cyan,TEXT("2.Yetenek Kullanildi"));
-			SetAbilityPoint(GetAbilityPoint() - 30);
-			SetAIHealth(GetAIHealth() - 30);
-			SecondSkillCooldown = 8;
-			Completed = false;
-			SecondSkillCooldownReduction();
-			GetWorldTimerManager().SetTimer(SecondSkillTimer, this, &ABossFightCharacter::CompletedControl, 1.4f);	
+			GetWorldTimerManager().ClearTimer(WindUpTimer);
+			FBossFightStats::AddActiveTimers(-1);
 		}
+		Completed = true;
+	}
+}
+
+bool ABossFightCharacter::CanUseSkill(int32 SkillId, double Now, float Tolerance) const
+{
+	const bool bLockedOut = !Completed && GetWorldTimerManager().GetTimerRemaining(WindUpTimer) > Tolerance;
+	return IsInMeleeReach() && !bLockedOut && TSkillExecutor<ABossFightCharacter>::CanActivate(*this, SkillTable, SkillId, Now + Tolerance);
+}
+
+bool ABossFightCharacter::TryActivateSkill(int32 SkillId, float Tolerance)
+{
+	const double Now = GetCombatTime();
+	FIGHT_RECORD(Tolerance > 0.f ? EFightRecordType::PredictedSkill : EFightRecordType::Skill, Now, GetUniqueID(), (uint64)SkillId);
+	if(!CanUseSkill(SkillId, Now, Tolerance))
+	{
+		return false;
+	}
+	COMBAT_LOG_EVENT(Now, GetUniqueID(), ECombatEventType::SkillCast, (float)SkillId, SkillTable[SkillId].Damage);
+	const float WindUp = TSkillExecutor<ABossFightCharacter>::Execute(*this, SkillTable[SkillId], Now);
+	FBossFightStats::NoteCast();
+	// The client started its lockout half a round trip earlier
+	StartWindUp(WindUp - Tolerance);
+	return true;
+}
+
+void ABossFightCharacter::StartWindUp(float WindUp)
+{
+	if(WindUp <= 0.f)
+	{
+		return;
+	}
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	FBossFightStats::AddActiveTimers(TimerManager.IsTimerActive(WindUpTimer) ? 0 : 1);
+	Completed = false;
+	TimerManager.SetTimer(WindUpTimer, this, &ABossFightCharacter::CompletedControl, WindUp);
+}
+
+void ABossFightCharacter::ApplyPredictedSkill(const FPredictedSkill& Prediction)
+{
+	// Same as TSkillExecutor::Execute without the damage, at the time the skill was predicted
+	const FSkillDefinition& Skill = SkillTable[Prediction.SkillId];
+	if(Skill.Cost > 0.f)
+	{
+		Attributes.AddAbilityPoint(-Skill.Cost, Prediction.Time);
+	}
+	if(Skill.Cooldown > 0.f)
+	{
+		Attributes.EditCooldowns().Start(Skill.CooldownSlot, Prediction.Time, Skill.Cooldown);
 	}
-	
-	
 }
 
-void ABossFightCharacter::ThirdSkill()
+void ABossFightCharacter::RebuildPredictedState()
 {
-	FTimerHandle ThirdSkillTimer;
-	if(collision == true && ThirdSkillCooldown <= 0 && Completed == true)
+	Attributes.SetAbilityPointPool(RepAbilityPoint.ToAttribute(MaxAbilityPoint, AbilityPointRegenRate));
+	RepCooldowns.ApplyTo(Attributes.EditCooldowns());
+	for(const FPredictedSkill& Prediction : PredictedSkills)
 	{
-		
-		if(GetAbilityPoint() >= 40)
+		ApplyPredictedSkill(Prediction);
+	}
+}
+
+void ABossFightCharacter::ApplySkillDamage(float Damage)
+{
+	if(AAICharacter* Boss = EngagedBoss.Get())
+	{
+		DamageQueue->QueueDamage(Boss->DamageIndex, Damage, GetUniqueID());
+		if(Threat)
 		{
-			GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Cyan,TEXT("3.Yetenek Kullanildi"));
-			SetAbilityPoint(GetAbilityPoint() - 40);
-			SetAIHealth(GetAIHealth() - 40);
-			ThirdSkillCooldown = 10;
-			Completed = false;
-			ThirdSkillCooldownReduction();
-			GetWorldTimerManager().SetTimer(ThirdSkillTimer, this, &ABossFightCharacter::CompletedControl, 1.6f);	
-		}	
+			Threat->AddDamageThreat(Boss, this, Damage);
+		}
 	}
-	
-	
-	
 }
 
-void ABossFightCharacter::BasicAttack()
+void ABossFightCharacter::HandleDeath()
 {
-	FTimerHandle BasicAttackTimer;
-	if(collision == true  && Completed == true)
+	COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::Death, GetHealth());
+	OnDeath.Broadcast();
+	// Dead players leave their pawn in the pool instead of destroying it
+	if(HasAuthority())
 	{
-		GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Cyan,TEXT("Basic Attack Kullanildi"));
-		SetAIHealth(GetAIHealth() - 10);
-		Completed = false;
-		GetWorldTimerManager().SetTimer(BasicAttackTimer, this, &ABossFightCharacter::CompletedControl, 1.0f);
+		FIGHT_RECORD(EFightRecordType::Death, GetCombatTime(), GetUniqueID());
+		GetWorld()->GetSubsystem<UFighterPoolSubsystem>()->Release(this);
 	}
 }
 
-void ABossFightCharacter::CompletedControl()
+void ABossFightCharacter::HandleAttributesChanged(uint32 ChangedMask)
 {
-	Completed = true;
+	if(ChangedMask & FighterAttributeBit(EFighterAttribute::Health))
+	{
+		UpdateReplicatedHealth();
+	}
+	if(ChangedMask & FighterAttributeBit(EFighterAttribute::AbilityPoint))
+	{
+		UpdateReplicatedAbilityPoint();
+		ScheduleAbilityPointFull();
+	}
+	if(ChangedMask & FighterAttributeBit(EFighterAttribute::Cooldowns))
+	{
+		UpdateReplicatedCooldowns();
+	}
+	OnAttributesChanged.Broadcast((int32)ChangedMask);
 }
 
-void ABossFightCharacter::AbilityPointRestore()
+void ABossFightCharacter::SetHealth(float NewHealth)
 {
-	FTimerHandle AbilityPointRestoreTimer;
-	if(GetAbilityPoint() < 100)
+	if(DamageQueue && DamageIndex != INDEX_NONE)
 	{
-		SetAbilityPoint(GetAbilityPoint() + 1);
-		GetWorldTimerManager().SetTimer(AbilityPointRestoreTimer, this, &ABossFightCharacter::AbilityPointRestore, 0.3f);
+		DamageQueue->SetHealth(DamageIndex, NewHealth);
 	}
 	else
 	{
-		AbilityPointRestoreTrigger();
+		Attributes.SetHealth(NewHealth);
 	}
-	
 }
 
-void ABossFightCharacter::AbilityPointRestoreTrigger()
+void ABossFightCharacter::SetAIHealth(float NewAIHealth)
 {
-	FTimerHandle AbilityPointTriggerTimer;
-	GetWorldTimerManager().SetTimer(AbilityPointTriggerTimer, this, &ABossFightCharacter::AbilityPointRestore, 0.1f);
-	
+	if(AAICharacter* Boss = EngagedBoss.Get())
+	{
+		Boss->SetHealth(NewAIHealth);
+	}
+}
+
+float ABossFightCharacter::GetAIHealth() const
+{
+	const AAICharacter* Boss = EngagedBoss.Get();
+	return Boss ? Boss->GetHealth() : 0.f;
 }
 
-void ABossFightCharacter::FirstSkillCooldownReduction()
+void ABossFightCharacter::CompletedControl()
 {
-	FTimerHandle FirstSkillReductionTimer;
-	if(FirstSkillCooldown > 0)
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerWindUpCompleted);
+	FBossFightStats::AddActiveTimers(-1);
+	Completed = true;
+}
+
+double ABossFightCharacter::GetCombatTime() const
+{
+	// Server time on clients too, so replicated timestamps mean the same everywhere
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World ? World->GetTimeSeconds() : 0.0;
+}
+
+void ABossFightCharacter::SetAbilityPoint(float NewAbilityPoint)
+{
+	Attributes.SetAbilityPoint(NewAbilityPoint, GetCombatTime());
+}
+
+void ABossFightCharacter::UpdateReplicatedHealth()
+{
+	if(HasAuthority() && FCombatQuantization::UpdateHealth(RepHealth, GetHealth(), MaxHealth))
 	{
-		FirstSkillCooldown -= 1;
-		GetWorldTimerManager().SetTimer(FirstSkillReductionTimer, this, &ABossFightCharacter::FirstSkillCooldownReduction, 1.0f);
-		GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Black,TEXT("aa"));
+		MARK_PROPERTY_DIRTY_FROM_NAME(ABossFightCharacter, RepHealth, this);
 	}
 }
 
-void ABossFightCharacter::SecondSkillCooldownReduction()
+void ABossFightCharacter::UpdateReplicatedAbilityPoint()
 {
-	FTimerHandle SecondSkillReductionTimer;
-	if(SecondSkillCooldown > 0)
+	if(HasAuthority() && RepAbilityPoint.Update(Attributes.GetAbilityPointPool()))
 	{
-		SecondSkillCooldown -= 1;
-		GetWorldTimerManager().SetTimer(SecondSkillReductionTimer, this, &ABossFightCharacter::SecondSkillCooldownReduction, 1.0f);
-		GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Black,TEXT("aa"));
+		MARK_PROPERTY_DIRTY_FROM_NAME(ABossFightCharacter, RepAbilityPoint, this);
 	}
 }
 
-void ABossFightCharacter::ThirdSkillCooldownReduction()
+void ABossFightCharacter::UpdateReplicatedCooldowns()
 {
-	FTimerHandle ThirdSkillReductionTimer;
-	if(ThirdSkillCooldown > 0)
+	if(HasAuthority() && RepCooldowns.Update(Attributes.GetCooldowns()))
 	{
-		ThirdSkillCooldown -= 1;
-		GetWorldTimerManager().SetTimer(ThirdSkillReductionTimer, this, &ABossFightCharacter::ThirdSkillCooldownReduction, 1.0f);
-		GEngine->AddOnScreenDebugMessage(-1,1.0f,FColor::Black,TEXT("aa"));
+		MARK_PROPERTY_DIRTY_FROM_NAME(ABossFightCharacter, RepCooldowns, this);
 	}
 }
 
-void ABossFightCharacter::UseHealthPotion()
+void ABossFightCharacter::OnRep_Health()
+{
+	SetHealth(FCombatQuantization::DequantizeHealth(RepHealth, MaxHealth));
+}
+
+void ABossFightCharacter::OnRep_AbilityPoint()
 {
-	if(Health < 200 && HealthPotionCooldown <= 0 && HealthPotionPiece >0)
+	RebuildPredictedState();
+}
+
+void ABossFightCharacter::OnRep_Cooldowns()
+{
+	RebuildPredictedState();
+}
+
+void ABossFightCharacter::ScheduleAbilityPointFull()
+{
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	const bool bWasArmed = TimerManager.IsTimerActive(AbilityPointFullTimer);
+	if(!OnAbilityPointFull.IsBound())
 	{
-		if(Health < 200 && Health >= 150)
-		{
-			Health = 200;
-			
-		}
-		if(Health < 150 && Health > 0)
+		TimerManager.ClearTimer(AbilityPointFullTimer);
+	}
+	else
+	{
+		const double Now = GetCombatTime();
+		const double FullTime = Attributes.GetAbilityPointPool().GetFullTime(Now);
+		if(FullTime > Now && FullTime < FRegeneratingAttribute::NeverFull)
 		{
-			Health = Health + HealthPotion;
+			TimerManager.SetTimer(AbilityPointFullTimer, this, &ABossFightCharacter::BroadcastAbilityPointFull, (float)(FullTime - Now));
 		}
-		HealthPotionCooldown = 10;
-		HealthPotionPiece--;
-		HealthPotionCooldownReduction();
 	}
-	
+	FBossFightStats::AddActiveTimers((int32)TimerManager.IsTimerActive(AbilityPointFullTimer) - (int32)bWasArmed);
 }
 
-void ABossFightCharacter::UseAbilityPointPotion()
+void ABossFightCharacter::BroadcastAbilityPointFull()
 {
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerAbilityPointFull);
+	FBossFightStats::AddActiveTimers(-1);
+	COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::AbilityPointFull, GetAbilityPoint());
+	OnAbilityPointFull.Broadcast();
+}
 
-	if(AbilityPoint < 100 && AbilityPointPotionCooldown <= 0 && AbilityPointPotionPiece >0)
+void ABossFightCharacter::UseHealthPotion()
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerUsePotion);
+	if(!HasAuthority())
 	{
-		if(AbilityPoint < 100 && AbilityPoint >= 70)
-		{
-			AbilityPoint = 100;
-			
-		}
-		if(AbilityPoint < 70 && AbilityPoint > 0)
+		ServerUseHealthPotion();
+		return;
+	}
+	FIGHT_RECORD(EFightRecordType::HealthPotion, GetCombatTime(), GetUniqueID());
+	const float HealthBefore = Attributes.GetHealth();
+	if(Attributes.UseHealthPotion(GHealthPotionRules, GetCombatTime()))
+	{
+		// The damage subsystem owns the health, hand it the new value
+		SetHealth(Attributes.GetHealth());
+		if(Threat)
 		{
-			AbilityPoint = AbilityPoint + AbilityPointPotion;
+			Threat->AddHealingThreat(this, Attributes.GetHealth() - HealthBefore);
 		}
-		AbilityPointPotionCooldown = 10;
-		AbilityPointPotionPiece--;
-		AbilityPotionCooldownReduction();
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::Potion, 0.f, Attributes.GetHealthPotionCharges());
 	}
 }
 
-void ABossFightCharacter::AbilityPotionCooldownReduction()
+void ABossFightCharacter::UseAbilityPointPotion()
 {
-	FTimerHandle AbilityPointPotionTimer;
-	if(AbilityPointPotionCooldown > 0)
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PlayerUsePotion);
+	if(!HasAuthority())
 	{
-		AbilityPointPotionCooldown--;
-		GetWorldTimerManager().SetTimer(AbilityPointPotionTimer, this, &ABossFightCharacter::AbilityPotionCooldownReduction, 1.0f);
+		ServerUseAbilityPointPotion();
+		return;
+	}
+	FIGHT_RECORD(EFightRecordType::AbilityPointPotion, GetCombatTime(), GetUniqueID());
+	if(Attributes.UseAbilityPointPotion(GAbilityPointPotionRules, GetCombatTime()))
+	{
+		COMBAT_LOG_EVENT(GetCombatTime(), GetUniqueID(), ECombatEventType::Potion, 1.f, Attributes.GetAbilityPointPotionCharges());
 	}
- 
-	
 }
 
-void ABossFightCharacter::HealthPotionCooldownReduction()
+void ABossFightCharacter::ServerUseHealthPotion_Implementation()
 {
-	FTimerHandle HealthPotionTimer;
-	if(HealthPotionCooldown > 0)
-	{
-		HealthPotionCooldown--;
-		GetWorldTimerManager().SetTimer(HealthPotionTimer, this, &ABossFightCharacter::HealthPotionCooldownReduction, 1.0f);
-	}
-	
+	UseHealthPotion();
 }
 
+void ABossFightCharacter::ServerUseAbilityPointPotion_Implementation()
+{
+	UseAbilityPointPotion();
+}
 
+float ABossFightCharacter::GetFirstSkillCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::FirstSkill, GetCombatTime());
+}
 
+float ABossFightCharacter::GetSecondSkillCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::SecondSkill, GetCombatTime());
+}
 
+float ABossFightCharacter::GetThirdSkillCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::ThirdSkill, GetCombatTime());
+}
 
+float ABossFightCharacter::GetHealthPotionCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::HealthPotion, GetCombatTime());
+}
 
+float ABossFightCharacter::GetAbilityPointPotionCooldown() const
+{
+	return Attributes.GetCooldowns().GetRemaining(ECooldownSlot::AbilityPointPotion, GetCombatTime());
+}
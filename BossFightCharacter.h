@@ -4,8 +4,26 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "SkillDefinition.h"
+#include "CombatRules.h"
+#include "FighterAttributes.h"
+#include "CombatReplication.h"
 #include "BossFightCharacter.generated.h"
 
+class USkillTableAsset;
+class UBossPerceptionSubsystem;
+class UCombatDamageSubsystem;
+class UMeleeReachSubsystem;
+class UThreatSubsystem;
+class UStatusEffectSubsystem;
+class AAICharacter;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnAbilityPointFull);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnFighterDeath);
+/** ChangedAttributes holds one bit per EFighterAttribute */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFighterAttributesChanged, int32, ChangedAttributes);
+DECLARE_DELEGATE_OneParam(FUseSkillDelegate, int32);
+
 UCLASS(config=Game)
 class ABossFightCharacter : public ACharacter
 {
@@ -56,76 +74,214 @@ protected:
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	// End of APawn interface
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	/** Both tell UStartupLoadSubsystem the game is playable, on the server and on the owning client */
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void PawnClientRestart() override;
 
 public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
-	bool collision;
 	bool Completed;
-	UFUNCTION()
-	void OnOverlapEnd(class UPrimitiveComponent* OverlappedComp, class AActor* OtherActor, class UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	/** Index of this player in the boss perception subsystem, INDEX_NONE when not registered */
+	int32 PerceptionIndex;
+	/** Index of this player in the damage subsystem, INDEX_NONE when not registered */
+	int32 DamageIndex;
+	/** Boss in melee reach the skills land on */
+	TWeakObjectPtr<AAICharacter> EngagedBoss;
+	/** Number of bosses in melee reach, kept by UMeleeReachSubsystem */
+	int32 MeleeContacts;
+	UPROPERTY()
+	UMeleeReachSubsystem* MeleeReachSystem;
+	UPROPERTY()
+	UCombatDamageSubsystem* DamageQueue;
+	/** Server only, the damage and healing of the player feed the threat tables of the bosses */
+	UPROPERTY()
+	UThreatSubsystem* Threat;
+	/** Server only, buffs and debuffs of the player */
+	UPROPERTY()
+	UStatusEffectSubsystem* StatusEffects;
+	/** Called by UMeleeReachSubsystem when a boss comes within or leaves melee reach */
+	void OnMeleeContactBegin(AAICharacter* Boss);
+	void OnMeleeContactEnd(AAICharacter* Boss);
+	FORCEINLINE bool IsInMeleeReach() const { return MeleeContacts > 0; }
 
-	UFUNCTION()
-		void BeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-	UPROPERTY(EditDefaultsOnly)
-	class UCapsuleComponent* BossFightCharacterCompCapsule;
-
-	void FirstSkill();
-	void SecondSkill();
-	void ThirdSkill();
-	void BasicAttack();
+	/** Called by UFighterPoolSubsystem: a pooled pawn leaves every batch, an unpooled one rejoins them reset */
+	void SetInPool(bool bNewInPool);
+	FORCEINLINE bool IsInPool() const { return bInPool; }
+
+	/** Seconds a predicted skill may arrive early on the server, FFighterDefaults so fight replays use it as well */
+	static constexpr float SkillPredictionTolerance = FFighterDefaults::SkillPredictionTolerance;
+	/** Predicted skills waiting for the server, more are sent without prediction */
+	static constexpr int32 MaxPredictedSkills = 8;
+
+	/**
+	 * Uses a skill of the skill table on the boss in reach.
+	 * The owning client applies cost, cooldown and wind-up lockout right away under a prediction key and asks the
+	 * server, which answers with ClientAckSkill; a rejected skill is rolled back.
+	 */
+	void UseSkill(int32 SkillId);
+	/** Skills of the skill table, their ids run from 0 */
+	FORCEINLINE int32 GetNumSkills() const { return SkillTable.Num(); }
+	/** PredictionKey 0 means the client did not predict the skill and expects no answer */
+	UFUNCTION(Server, Reliable)
+	void ServerUseSkill(int32 SkillId, uint16 PredictionKey);
+	UFUNCTION(Client, Reliable)
+	void ClientAckSkill(uint16 PredictionKey, bool bAccepted);
 	void CompletedControl();
-	void AbilityPointRestore();
-	void AbilityPointRestoreTrigger();
 
-	void FirstSkillCooldownReduction();
-	void SecondSkillCooldownReduction();
-	void ThirdSkillCooldownReduction();
+	/** Skills of the player, the built-in defaults are used when not set */
+	UPROPERTY(EditDefaultsOnly, Category = "Skill")
+	USkillTableAsset* SkillTableAsset;
+
+	/** TSkillExecutor interface */
+	FORCEINLINE float GetSkillResource() const { return GetAbilityPoint(); }
+	FORCEINLINE void SpendSkillResource(float Amount) { Attributes.AddAbilityPoint(-Amount, GetCombatTime()); }
+	void ApplySkillDamage(float Damage);
+	FORCEINLINE FCooldownTracker& GetCooldowns() { return Attributes.EditCooldowns(); }
+	FORCEINLINE const FCooldownTracker& GetCooldowns() const { return Attributes.GetCooldowns(); }
+
+	/** Broadcast when ability points reach the cap. A timer is only armed while something is bound. */
+	UPROPERTY(BlueprintAssignable, Category = "AbilityPoint")
+	FOnAbilityPointFull OnAbilityPointFull;
+	void BroadcastAbilityPointFull();
+
+	/** Broadcast once when health drops to zero, the pawn goes back to the fighter pool afterwards */
+	UPROPERTY(BlueprintAssignable, Category = "Health")
+	FOnFighterDeath OnDeath;
+	void HandleDeath();
+
+	/** Broadcast once per frame at most, after the attributes changed */
+	UPROPERTY(BlueprintAssignable, Category = "Attributes")
+	FOnFighterAttributesChanged OnAttributesChanged;
+	/** Called by UCombatDamageSubsystem once per frame with the attributes that changed, feeds replication and the UI */
+	void HandleAttributesChanged(uint32 ChangedMask);
 
 	void UseHealthPotion();
 	void UseAbilityPointPotion();
+	UFUNCTION(Server, Reliable)
+	void ServerUseHealthPotion();
+	UFUNCTION(Server, Reliable)
+	void ServerUseAbilityPointPotion();
 
-	void HealthPotionCooldownReduction();
-	void AbilityPotionCooldownReduction();
+	/** Remaining cooldowns in seconds, 0 when ready */
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetFirstSkillCooldown() const;
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetSecondSkillCooldown() const;
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetThirdSkillCooldown() const;
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetHealthPotionCooldown() const;
+	UFUNCTION(BlueprintPure, Category = "Cooldown")
+	float GetAbilityPointPotionCooldown() const;
 private:
-	float HealthPotion;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
+	/** World time used for cooldowns and regeneration */
+	double GetCombatTime() const;
+	/** Arms the "AP full" timer if a listener is bound, clears it otherwise */
+	void ScheduleAbilityPointFull();
+	/** Resets the combat state to the class defaults and registers with the batches, on spawn and when leaving the pool */
+	void JoinCombat();
+	/** Unregisters from the batches, on EndPlay and when entering the pool */
+	void LeaveCombat();
+
+	/** A skill the owning client applied before the server confirmed it */
+	struct FPredictedSkill
+	{
+		uint16 Key;
+		int32 SkillId;
+		double Time;
+	};
+
+	/** True if the skill can be used now; Tolerance lets the lockout and cooldowns end that much early */
+	bool CanUseSkill(int32 SkillId, double Now, float Tolerance) const;
+	/** Server and standalone: uses the skill for real, returns false if it could not be used */
+	bool TryActivateSkill(int32 SkillId, float Tolerance);
+	/** Locks skills for the wind-up of the last one */
+	void StartWindUp(float WindUp);
+	/** Applies cost and cooldown of a predicted skill, the server applies the damage */
+	void ApplyPredictedSkill(const FPredictedSkill& Prediction);
+	/** Client: replicated state plus every skill still waiting for the server */
+	void RebuildPredictedState();
+
+	TArray<FPredictedSkill, TInlineAllocator<MaxPredictedSkills>> PredictedSkills;
+	uint16 NextPredictionKey;
+
+	/** Server only: copy the attributes to their replicated forms and mark the ones that changed dirty */
+	void UpdateReplicatedHealth();
+	void UpdateReplicatedAbilityPoint();
+	void UpdateReplicatedCooldowns();
+
+	UFUNCTION()
+	void OnRep_Health();
+	UFUNCTION()
+	void OnRep_AbilityPoint();
+	UFUNCTION()
+	void OnRep_Cooldowns();
+	UFUNCTION()
+	void OnRep_InPool();
+
+	/** Quantized Health, sent to everyone */
+	UPROPERTY(ReplicatedUsing = OnRep_Health)
+	uint16 RepHealth;
+	/** Ability points and cooldowns, only sent to the owning client */
+	UPROPERTY(ReplicatedUsing = OnRep_AbilityPoint)
+	FRepRegeneratingAttribute RepAbilityPoint;
+	UPROPERTY(ReplicatedUsing = OnRep_Cooldowns)
+	FRepCooldowns RepCooldowns;
+	/** Hidden in UFighterPoolSubsystem, out of every batch */
+	UPROPERTY(ReplicatedUsing = OnRep_InPool)
+	bool bInPool;
+
+	FFighterAttributes Attributes;
+	FSkillTable SkillTable;
+	FTimerHandle AbilityPointFullTimer;
+	/** Locks skills until the wind-up of the last one is over */
+	FTimerHandle WindUpTimer;
+
+	/** Potions at the start of a fight */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
 	float HealthPotionPiece;
-	float AbilityPointPotion;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
 	float AbilityPointPotionPiece;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	float Health = 200;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
+	/** Starting and maximum health */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float MaxHealth = FFighterDefaults::PlayerMaxHealth;
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
 	float Attack = 10;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	float AbilityPoint = 100;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	float AIHealth = 500;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int FirstSkillCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int SecondSkillCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int ThirdSkillCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int AbilityPointPotionCooldown;
-	UPROPERTY(EditDefaultsOnly,BlueprintReadWrite,meta=(AllowPrivateAccess="true"))
-	int HealthPotionCooldown;
+	/** Starting and maximum ability points */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float MaxAbilityPoint = FFighterDefaults::MaxAbilityPoint;
+	/** Ability points regenerated per second */
+	UPROPERTY(EditDefaultsOnly,BlueprintReadOnly,meta=(AllowPrivateAccess="true"))
+	float AbilityPointRegenRate = FFighterDefaults::AbilityPointRegenRate;
 public:
-	FORCEINLINE void SetHealth(float NewHealth) { Health = NewHealth; }
-	FORCEINLINE float GetHealth() { return Health; }
+	FORCEINLINE const FFighterAttributes& GetAttributes() const { return Attributes; }
+
+	void SetHealth(float NewHealth);
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetHealth() const { return Attributes.GetHealth(); }
+
+	FORCEINLINE void SetAttack(float NewAttack) { Attributes.SetAttack(NewAttack); }
+	FORCEINLINE float GetAttack() const { return Attributes.GetAttack(); }
 
-	FORCEINLINE void SetAttack(float NewAttack) { Attack = NewAttack; }
-	FORCEINLINE float GetAttack() { return Attack; }
+	void SetAbilityPoint(float NewAbilityPoint);
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetAbilityPoint() const { return Attributes.GetAbilityPoint(GetCombatTime()); }
 
-	FORCEINLINE void SetAbilityPoint(float NewAbilityPoint) { AbilityPoint = NewAbilityPoint; }
-	FORCEINLINE float GetAbilityPoint() { return AbilityPoint; }
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetHealthPotionCharges() const { return Attributes.GetHealthPotionCharges(); }
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetAbilityPointPotionCharges() const { return Attributes.GetAbilityPointPotionCharges(); }
 
-	FORCEINLINE void SetAIHealth(float NewAIHealth) { AIHealth = NewAIHealth; }
-	FORCEINLINE float GetAIHealth() { return AIHealth; }
+	/** Health of the engaged boss, 0 without one. The boss owns it. */
+	void SetAIHealth(float NewAIHealth);
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetAIHealth() const;
 };
 
@@ -2,14 +2,66 @@
 
 #include "BossFightGameMode.h"
 #include "BossFightCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "AICharacter.h"
+#include "FighterPoolSubsystem.h"
+#include "StartupLoadSubsystem.h"
+#include "GameFramework/PlayerController.h"
 
 ABossFightGameMode::ABossFightGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// set default pawn class to our Blueprinted character, loaded asynchronously when the map starts
+	PlayerPawnClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter.BP_ThirdPersonCharacter_C")));
+	bPlayerPawnLoaded = false;
+}
+
+void ABossFightGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	UStartupLoadSubsystem* StartupLoads = GetWorld()->GetSubsystem<UStartupLoadSubsystem>();
+	StartupLoads->BeginLoading(*this);
+	StartupLoads->CallWhenDone(EStartupStage::PlayerPawn, FSimpleDelegate::CreateUObject(this, &ABossFightGameMode::OnPlayerPawnLoaded));
+	StartupLoads->CallWhenDone(EStartupStage::Fighters, FSimpleDelegate::CreateUObject(this, &ABossFightGameMode::OnFightersLoaded));
+}
+
+void ABossFightGameMode::OnPlayerPawnLoaded()
+{
+	if (UClass* PawnClass = PlayerPawnClass.Get())
+	{
+		DefaultPawnClass = PawnClass;
+	}
+	bPlayerPawnLoaded = true;
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* Player = Iterator->Get();
+		if (Player && !Player->GetPawn() && PlayerCanRestart(Player))
+		{
+			RestartPlayer(Player);
+		}
+	}
+}
+
+void ABossFightGameMode::OnFightersLoaded()
+{
+	UFighterPoolSubsystem* Pool = GetWorld()->GetSubsystem<UFighterPoolSubsystem>();
+	for (const FFighterPoolEntry& Entry : PrewarmedFighters)
+	{
+		Pool->Prewarm(Entry.Class.Get(), Entry.Count);
+	}
+}
+
+bool ABossFightGameMode::PlayerCanRestart_Implementation(APlayerController* Player)
+{
+	return bPlayerPawnLoaded && Super::PlayerCanRestart_Implementation(Player);
+}
+
+APawn* ABossFightGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	UClass* PawnClass = GetDefaultPawnClassForController(NewPlayer);
+	if (PawnClass && PawnClass->IsChildOf(ACharacter::StaticClass()))
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		return GetWorld()->GetSubsystem<UFighterPoolSubsystem>()->Acquire(TSubclassOf<ACharacter>(PawnClass), SpawnTransform);
 	}
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
 }
@@ -4,8 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "FighterPoolSubsystem.h"
 #include "BossFightGameMode.generated.h"
 
+class AAICharacter;
+
 UCLASS(minimalapi)
 class ABossFightGameMode : public AGameModeBase
 {
@@ -13,6 +16,31 @@ class ABossFightGameMode : public AGameModeBase
 
 public:
 	ABossFightGameMode();
+
+	/** Pawn of the players, loaded by UStartupLoadSubsystem; players spawn once it is in */
+	UPROPERTY(EditDefaultsOnly, Category = "Classes")
+	TSoftClassPtr<APawn> PlayerPawnClass;
+
+	/** Bosses the map spawns or places, loaded with their meshes and animations by UStartupLoadSubsystem */
+	UPROPERTY(EditDefaultsOnly, Category = "Classes")
+	TArray<TSoftClassPtr<AAICharacter>> BossClasses;
+
+	/** Bosses and player pawns spawned into UFighterPoolSubsystem once their classes are loaded */
+	UPROPERTY(EditDefaultsOnly, Category = "Pool")
+	TArray<FFighterPoolEntry> PrewarmedFighters;
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	/** Holds players back until the player pawn class is loaded */
+	virtual bool PlayerCanRestart_Implementation(APlayerController* Player) override;
+	/** Player pawns come out of the fighter pool */
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
+private:
+	/** Makes the loaded pawn the default one and spawns the players that were held back */
+	void OnPlayerPawnLoaded();
+	void OnFightersLoaded();
+
+	bool bPlayerPawnLoaded;
 };
 
 
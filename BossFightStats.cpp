@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BossFightStats.h"
+#include "StartupLoadSubsystem.h"
+
+DEFINE_STAT(STAT_BossFight_BrainTick);
+DEFINE_STAT(STAT_BossFight_DamageTick);
+DEFINE_STAT(STAT_BossFight_MeleeReachTick);
+DEFINE_STAT(STAT_BossFight_PerceptionTick);
+DEFINE_STAT(STAT_BossFight_PursuitTick);
+DEFINE_STAT(STAT_BossFight_PursuitSample);
+DEFINE_STAT(STAT_BossFight_StatusEffectTick);
+DEFINE_STAT(STAT_BossFight_ThreatTick);
+DEFINE_STAT(STAT_BossFight_LoadTestTick);
+DEFINE_STAT(STAT_BossFight_RoamQueryTick);
+DEFINE_STAT(STAT_BossFight_RoamQueryBatch);
+DEFINE_STAT(STAT_BossFight_RoamQueryCompleted);
+
+DEFINE_STAT(STAT_BossFight_NewMovement);
+DEFINE_STAT(STAT_BossFight_OnRoamPointReady);
+DEFINE_STAT(STAT_BossFight_SeePawn);
+DEFINE_STAT(STAT_BossFight_OnHearNoise);
+DEFINE_STAT(STAT_BossFight_BossContactBegin);
+DEFINE_STAT(STAT_BossFight_BossExecuteSkill);
+DEFINE_STAT(STAT_BossFight_BossAbilityPointFull);
+
+DEFINE_STAT(STAT_BossFight_PlayerContactBegin);
+DEFINE_STAT(STAT_BossFight_PlayerContactEnd);
+DEFINE_STAT(STAT_BossFight_PlayerUseSkill);
+DEFINE_STAT(STAT_BossFight_PlayerWindUpCompleted);
+DEFINE_STAT(STAT_BossFight_PlayerUsePotion);
+DEFINE_STAT(STAT_BossFight_PlayerAbilityPointFull);
+
+DEFINE_STAT(STAT_BossFight_Casts);
+DEFINE_STAT(STAT_BossFight_CastsPerSecond);
+DEFINE_STAT(STAT_BossFight_ActiveTimers);
+DEFINE_STAT(STAT_BossFight_NavQueries);
+DEFINE_STAT(STAT_BossFight_NavQueriesTotal);
+DEFINE_STAT(STAT_BossFight_PerceptionEvents);
+DEFINE_STAT(STAT_BossFight_PerceptionStimuliRaw);
+DEFINE_STAT(STAT_BossFight_PerceptionStimuliCoalesced);
+DEFINE_STAT(STAT_BossFight_PooledFighters);
+DEFINE_STAT(STAT_BossFight_FighterSpawns);
+DEFINE_STAT(STAT_BossFight_BossesEngaged);
+DEFINE_STAT(STAT_BossFight_BossesNear);
+DEFINE_STAT(STAT_BossFight_BossesFar);
+DEFINE_STAT(STAT_BossFight_AttributeChanges);
+DEFINE_STAT(STAT_BossFight_PursuitFields);
+DEFINE_STAT(STAT_BossFight_PursuingBosses);
+DEFINE_STAT(STAT_BossFight_StatusEffects);
+DEFINE_STAT(STAT_BossFight_ThreatUpdates);
+DEFINE_STAT(STAT_BossFight_StartupPlayerPawn);
+DEFINE_STAT(STAT_BossFight_StartupFighters);
+DEFINE_STAT(STAT_BossFight_StartupPlayable);
+
+TRACE_DECLARE_INT_COUNTER(BossFight_CastsPerSecond, TEXT("BossFight/Casts per second"));
+TRACE_DECLARE_INT_COUNTER(BossFight_ActiveTimers, TEXT("BossFight/Active gameplay timers"));
+TRACE_DECLARE_INT_COUNTER(BossFight_NavQueries, TEXT("BossFight/Nav queries (total)"));
+TRACE_DECLARE_INT_COUNTER(BossFight_PerceptionEvents, TEXT("BossFight/Perception events"));
+TRACE_DECLARE_INT_COUNTER(BossFight_PerceptionStimuliRaw, TEXT("BossFight/Perception stimuli (raw)"));
+TRACE_DECLARE_INT_COUNTER(BossFight_PerceptionStimuliCoalesced, TEXT("BossFight/Perception stimuli (coalesced)"));
+TRACE_DECLARE_INT_COUNTER(BossFight_PooledFighters, TEXT("BossFight/Pooled fighters"));
+TRACE_DECLARE_INT_COUNTER(BossFight_FighterSpawns, TEXT("BossFight/Fighter spawns"));
+TRACE_DECLARE_INT_COUNTER(BossFight_BossesEngaged, TEXT("BossFight/Bosses engaged"));
+TRACE_DECLARE_INT_COUNTER(BossFight_BossesNear, TEXT("BossFight/Bosses near"));
+TRACE_DECLARE_INT_COUNTER(BossFight_BossesFar, TEXT("BossFight/Bosses far"));
+TRACE_DECLARE_INT_COUNTER(BossFight_AttributeChanges, TEXT("BossFight/Fighters with attribute changes"));
+TRACE_DECLARE_INT_COUNTER(BossFight_PursuitFields, TEXT("BossFight/Pursuit flow fields"));
+TRACE_DECLARE_INT_COUNTER(BossFight_PursuingBosses, TEXT("BossFight/Pursuing bosses"));
+TRACE_DECLARE_INT_COUNTER(BossFight_StatusEffects, TEXT("BossFight/Status effects"));
+TRACE_DECLARE_INT_COUNTER(BossFight_ThreatUpdates, TEXT("BossFight/Threat updates"));
+TRACE_DECLARE_FLOAT_COUNTER(BossFight_StartupPlayerPawn, TEXT("BossFight/Startup player pawn loaded (ms)"));
+TRACE_DECLARE_FLOAT_COUNTER(BossFight_StartupFighters, TEXT("BossFight/Startup fighters loaded (ms)"));
+TRACE_DECLARE_FLOAT_COUNTER(BossFight_StartupPlayable, TEXT("BossFight/Startup first playable frame (ms)"));
+
+int32 FBossFightStats::CastsThisSecond = 0;
+double FBossFightStats::SecondStartTime = 0.0;
+int32 FBossFightStats::ActiveTimers = 0;
+int32 FBossFightStats::NavQueriesTotal = 0;
+int32 FBossFightStats::PooledFighters = 0;
+
+void FBossFightStats::NoteCast()
+{
+	CastsThisSecond++;
+	INC_DWORD_STAT(STAT_BossFight_Casts);
+}
+
+void FBossFightStats::AddActiveTimers(int32 Delta)
+{
+	if (Delta == 0)
+	{
+		return;
+	}
+	ActiveTimers += Delta;
+	INC_DWORD_STAT_BY(STAT_BossFight_ActiveTimers, Delta);
+	TRACE_COUNTER_SET(BossFight_ActiveTimers, ActiveTimers);
+}
+
+void FBossFightStats::AddNavQueries(int32 Count)
+{
+	NavQueriesTotal += Count;
+	INC_DWORD_STAT_BY(STAT_BossFight_NavQueries, Count);
+	INC_DWORD_STAT_BY(STAT_BossFight_NavQueriesTotal, Count);
+	TRACE_COUNTER_SET(BossFight_NavQueries, NavQueriesTotal);
+}
+
+void FBossFightStats::NotePerceptionEvent()
+{
+	INC_DWORD_STAT(STAT_BossFight_PerceptionEvents);
+	TRACE_COUNTER_INCREMENT(BossFight_PerceptionEvents);
+}
+
+void FBossFightStats::AddPerceptionStimuli(int32 Raw, int32 Coalesced)
+{
+	INC_DWORD_STAT_BY(STAT_BossFight_PerceptionStimuliRaw, Raw);
+	INC_DWORD_STAT_BY(STAT_BossFight_PerceptionStimuliCoalesced, Coalesced);
+	TRACE_COUNTER_ADD(BossFight_PerceptionStimuliRaw, Raw);
+	TRACE_COUNTER_ADD(BossFight_PerceptionStimuliCoalesced, Coalesced);
+}
+
+void FBossFightStats::AddPooledFighters(int32 Delta)
+{
+	PooledFighters += Delta;
+	INC_DWORD_STAT_BY(STAT_BossFight_PooledFighters, Delta);
+	TRACE_COUNTER_SET(BossFight_PooledFighters, PooledFighters);
+}
+
+void FBossFightStats::NoteFighterSpawn()
+{
+	INC_DWORD_STAT(STAT_BossFight_FighterSpawns);
+	TRACE_COUNTER_INCREMENT(BossFight_FighterSpawns);
+}
+
+void FBossFightStats::SetBossLODCounts(int32 Engaged, int32 Near, int32 Far)
+{
+	SET_DWORD_STAT(STAT_BossFight_BossesEngaged, Engaged);
+	SET_DWORD_STAT(STAT_BossFight_BossesNear, Near);
+	SET_DWORD_STAT(STAT_BossFight_BossesFar, Far);
+	TRACE_COUNTER_SET(BossFight_BossesEngaged, Engaged);
+	TRACE_COUNTER_SET(BossFight_BossesNear, Near);
+	TRACE_COUNTER_SET(BossFight_BossesFar, Far);
+}
+
+void FBossFightStats::SetAttributeChanges(int32 Count)
+{
+	SET_DWORD_STAT(STAT_BossFight_AttributeChanges, Count);
+	TRACE_COUNTER_SET(BossFight_AttributeChanges, Count);
+}
+
+void FBossFightStats::SetPursuitCounts(int32 Fields, int32 Pursuers)
+{
+	SET_DWORD_STAT(STAT_BossFight_PursuitFields, Fields);
+	SET_DWORD_STAT(STAT_BossFight_PursuingBosses, Pursuers);
+	TRACE_COUNTER_SET(BossFight_PursuitFields, Fields);
+	TRACE_COUNTER_SET(BossFight_PursuingBosses, Pursuers);
+}
+
+void FBossFightStats::SetStatusEffects(int32 Count)
+{
+	SET_DWORD_STAT(STAT_BossFight_StatusEffects, Count);
+	TRACE_COUNTER_SET(BossFight_StatusEffects, Count);
+}
+
+void FBossFightStats::SetThreatUpdates(int32 Count)
+{
+	SET_DWORD_STAT(STAT_BossFight_ThreatUpdates, Count);
+	TRACE_COUNTER_SET(BossFight_ThreatUpdates, Count);
+}
+
+void FBossFightStats::SetStartupStageTime(EStartupStage Stage, float Seconds)
+{
+	const float Milliseconds = Seconds * 1000.f;
+	switch (Stage)
+	{
+	case EStartupStage::PlayerPawn:
+		SET_FLOAT_STAT(STAT_BossFight_StartupPlayerPawn, Milliseconds);
+		TRACE_COUNTER_SET(BossFight_StartupPlayerPawn, Milliseconds);
+		break;
+	case EStartupStage::Fighters:
+		SET_FLOAT_STAT(STAT_BossFight_StartupFighters, Milliseconds);
+		TRACE_COUNTER_SET(BossFight_StartupFighters, Milliseconds);
+		break;
+	case EStartupStage::Playable:
+		SET_FLOAT_STAT(STAT_BossFight_StartupPlayable, Milliseconds);
+		TRACE_COUNTER_SET(BossFight_StartupPlayable, Milliseconds);
+		break;
+	default:
+		break;
+	}
+}
+
+void FBossFightStats::Update(double Now)
+{
+	// A new world starts its clock at zero again
+	if (Now < SecondStartTime)
+	{
+		SecondStartTime = Now;
+		CastsThisSecond = 0;
+	}
+	if (Now - SecondStartTime < 1.0)
+	{
+		return;
+	}
+	SET_DWORD_STAT(STAT_BossFight_CastsPerSecond, CastsThisSecond);
+	TRACE_COUNTER_SET(BossFight_CastsPerSecond, CastsThisSecond);
+	CastsThisSecond = 0;
+	SecondStartTime = Now;
+}
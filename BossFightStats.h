@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+DECLARE_STATS_GROUP(TEXT("BossFight"), STATGROUP_BossFight, STATCAT_Advanced);
+
+enum class EStartupStage : uint8;
+
+// Subsystem batches
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Brain Tick"), STAT_BossFight_BrainTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Damage Tick"), STAT_BossFight_DamageTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Melee Reach Tick"), STAT_BossFight_MeleeReachTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Perception Tick"), STAT_BossFight_PerceptionTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pursuit Tick"), STAT_BossFight_PursuitTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pursuit Field Sample"), STAT_BossFight_PursuitSample, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Status Effect Tick"), STAT_BossFight_StatusEffectTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Threat Tick"), STAT_BossFight_ThreatTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Load Test Tick"), STAT_BossFight_LoadTestTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Roam Query Tick"), STAT_BossFight_RoamQueryTick, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Roam Query Batch (worker)"), STAT_BossFight_RoamQueryBatch, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Roam Query Completed"), STAT_BossFight_RoamQueryCompleted, STATGROUP_BossFight, BOSSFIGHT_API);
+
+// Boss entry points
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss NewMovement"), STAT_BossFight_NewMovement, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss OnRoamPointReady"), STAT_BossFight_OnRoamPointReady, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss SeePawn"), STAT_BossFight_SeePawn, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss OnHearNoise"), STAT_BossFight_OnHearNoise, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss MeleeContactBegin"), STAT_BossFight_BossContactBegin, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss ExecuteSkill"), STAT_BossFight_BossExecuteSkill, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Boss AbilityPointFull"), STAT_BossFight_BossAbilityPointFull, STATGROUP_BossFight, BOSSFIGHT_API);
+
+// Player entry points
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player MeleeContactBegin"), STAT_BossFight_PlayerContactBegin, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player MeleeContactEnd"), STAT_BossFight_PlayerContactEnd, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player UseSkill"), STAT_BossFight_PlayerUseSkill, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player WindUpCompleted"), STAT_BossFight_PlayerWindUpCompleted, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player UsePotion"), STAT_BossFight_PlayerUsePotion, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player AbilityPointFull"), STAT_BossFight_PlayerAbilityPointFull, STATGROUP_BossFight, BOSSFIGHT_API);
+
+// Counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Casts"), STAT_BossFight_Casts, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Casts per second"), STAT_BossFight_CastsPerSecond, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active gameplay timers"), STAT_BossFight_ActiveTimers, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nav queries"), STAT_BossFight_NavQueries, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Nav queries (total)"), STAT_BossFight_NavQueriesTotal, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Perception events"), STAT_BossFight_PerceptionEvents, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Perception stimuli (raw)"), STAT_BossFight_PerceptionStimuliRaw, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Perception stimuli (coalesced)"), STAT_BossFight_PerceptionStimuliCoalesced, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled fighters"), STAT_BossFight_PooledFighters, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Fighter spawns"), STAT_BossFight_FighterSpawns, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bosses engaged"), STAT_BossFight_BossesEngaged, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bosses near"), STAT_BossFight_BossesNear, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bosses far"), STAT_BossFight_BossesFar, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Fighters with attribute changes"), STAT_BossFight_AttributeChanges, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pursuit flow fields"), STAT_BossFight_PursuitFields, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pursuing bosses"), STAT_BossFight_PursuingBosses, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Status effects"), STAT_BossFight_StatusEffects, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Threat updates"), STAT_BossFight_ThreatUpdates, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Startup player pawn loaded (ms)"), STAT_BossFight_StartupPlayerPawn, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Startup fighters loaded (ms)"), STAT_BossFight_StartupFighters, STATGROUP_BossFight, BOSSFIGHT_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Startup first playable frame (ms)"), STAT_BossFight_StartupPlayable, STATGROUP_BossFight, BOSSFIGHT_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_CastsPerSecond);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_ActiveTimers);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_NavQueries);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_PerceptionEvents);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_PerceptionStimuliRaw);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_PerceptionStimuliCoalesced);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_PooledFighters);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_FighterSpawns);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_BossesEngaged);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_BossesNear);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_BossesFar);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_AttributeChanges);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_PursuitFields);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_PursuingBosses);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_StatusEffects);
+TRACE_DECLARE_INT_COUNTER_EXTERN(BossFight_ThreatUpdates);
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(BossFight_StartupPlayerPawn);
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(BossFight_StartupFighters);
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(BossFight_StartupPlayable);
+
+/** Cycle counter for "stat BossFight" plus a CPU event of the same name for Unreal Insights */
+#define BOSSFIGHT_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+
+/** Gameplay counters of the module, published to both the stat system and trace counters. Game thread only. */
+struct BOSSFIGHT_API FBossFightStats
+{
+	/** A player or a boss cast a skill */
+	static void NoteCast();
+	/** A gameplay timer was armed (positive) or fired or cleared (negative) */
+	static void AddActiveTimers(int32 Delta);
+	/** Navigation queries handed to the navigation data */
+	static void AddNavQueries(int32 Count);
+	/** A boss was told it saw or heard a pawn */
+	static void NotePerceptionEvent();
+	/** Sightings and noises buffered this frame, and what was left of them after coalescing them per boss */
+	static void AddPerceptionStimuli(int32 Raw, int32 Coalesced);
+	/** Fighters were put into (positive) or taken out of (negative) the fighter pool */
+	static void AddPooledFighters(int32 Delta);
+	/** The fighter pool had to spawn an actor */
+	static void NoteFighterSpawn();
+	/** Bosses in each significance tier, called once per frame */
+	static void SetBossLODCounts(int32 Engaged, int32 Near, int32 Far);
+	/** Fighters whose attributes changed this frame, called once per frame */
+	static void SetAttributeChanges(int32 Count);
+	/** Flow fields of pursued players and bosses pursuing them, called once per frame */
+	static void SetPursuitCounts(int32 Fields, int32 Pursuers);
+	/** Buffs and debuffs alive, called once per frame */
+	static void SetStatusEffects(int32 Count);
+	/** Threat changes of the last frame, called once per frame */
+	static void SetThreatUpdates(int32 Count);
+	/** A startup stage of the world finished, Seconds after the world started */
+	static void SetStartupStageTime(EStartupStage Stage, float Seconds);
+	/** Publishes the casts of the last full second, called once per frame */
+	static void Update(double Now);
+
+	/** Gameplay timers armed right now and navigation queries since startup, for the load test */
+	static FORCEINLINE int32 GetActiveTimers() { return ActiveTimers; }
+	static FORCEINLINE int32 GetNavQueriesTotal() { return NavQueriesTotal; }
+
+private:
+	static int32 CastsThisSecond;
+	static double SecondStartTime;
+	static int32 ActiveTimers;
+	static int32 NavQueriesTotal;
+	static int32 PooledFighters;
+};
@@ -0,0 +1,482 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BossPerceptionSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightCharacter.h"
+#include "BossFightStats.h"
+#include "Components/PawnNoiseEmitterComponent.h"
+#include "Engine/World.h"
+
+void UBossPerceptionSubsystem::RegisterBoss(AAICharacter* Boss)
+{
+	check(Boss);
+	Boss->PerceptionIndex = Bosses.Add(Boss);
+	BossLocations.Add(Boss->GetActorLocation());
+	NextSenseTimes.Add(0.0);
+	SightRadii.Add(Boss->SightRadius);
+	PeripheralVisionCosines.Add(FMath::Cos(FMath::DegreesToRadians(Boss->PeripheralVisionAngle)));
+	HearingThresholds.Add(Boss->HearingThreshold);
+	LOSHearingThresholds.Add(Boss->LOSHearingThreshold);
+	SensingIntervals.Add(Boss->SensingInterval);
+	MaxLOSHearingThreshold = FMath::Max(MaxLOSHearingThreshold, Boss->LOSHearingThreshold);
+
+	// Rated for real within a few frames
+	LODs.Add(EBossLOD::Near);
+	LastEngagedTimes.Add(-EngagedMemory);
+	StimulusTargets.AddDefaulted();
+	StimulusLocations.Add(FVector::ZeroVector);
+	LODCounts[(int32)EBossLOD::Near]++;
+	Boss->SetLOD(EBossLOD::Near);
+}
+
+void UBossPerceptionSubsystem::UnregisterBoss(AAICharacter* Boss)
+{
+	const int32 BossIndex = Boss ? Boss->PerceptionIndex : INDEX_NONE;
+	if (!Bosses.IsValidIndex(BossIndex) || Bosses[BossIndex] != Boss)
+	{
+		return;
+	}
+
+	Bosses.RemoveAtSwap(BossIndex, 1, false);
+	BossLocations.RemoveAtSwap(BossIndex, 1, false);
+	NextSenseTimes.RemoveAtSwap(BossIndex, 1, false);
+	SightRadii.RemoveAtSwap(BossIndex, 1, false);
+	PeripheralVisionCosines.RemoveAtSwap(BossIndex, 1, false);
+	HearingThresholds.RemoveAtSwap(BossIndex, 1, false);
+	LOSHearingThresholds.RemoveAtSwap(BossIndex, 1, false);
+	SensingIntervals.RemoveAtSwap(BossIndex, 1, false);
+	LODCounts[(int32)LODs[BossIndex]]--;
+	LODs.RemoveAtSwap(BossIndex, 1, false);
+	LastEngagedTimes.RemoveAtSwap(BossIndex, 1, false);
+	StimulusTargets.RemoveAtSwap(BossIndex, 1, false);
+	StimulusLocations.RemoveAtSwap(BossIndex, 1, false);
+	if (Bosses.IsValidIndex(BossIndex))
+	{
+		Bosses[BossIndex]->PerceptionIndex = BossIndex;
+	}
+	Boss->PerceptionIndex = INDEX_NONE;
+}
+
+void UBossPerceptionSubsystem::RegisterPlayer(ABossFightCharacter* Player)
+{
+	check(Player);
+	Player->PerceptionIndex = Players.Add(Player);
+	PlayerLocations.Add(Player->GetActorLocation());
+
+	// Noises made before registering are not news to anybody
+	const UPawnNoiseEmitterComponent* NoiseEmitter = Player->GetPawnNoiseEmitterComponent();
+	LastLocalNoiseTimes.Add(NoiseEmitter ? NoiseEmitter->GetLastNoiseTime(true) : 0.f);
+	LastRemoteNoiseTimes.Add(NoiseEmitter ? NoiseEmitter->GetLastNoiseTime(false) : 0.f);
+}
+
+void UBossPerceptionSubsystem::UnregisterPlayer(ABossFightCharacter* Player)
+{
+	const int32 PlayerIndex = Player ? Player->PerceptionIndex : INDEX_NONE;
+	if (!Players.IsValidIndex(PlayerIndex) || Players[PlayerIndex] != Player)
+	{
+		return;
+	}
+
+	Players.RemoveAtSwap(PlayerIndex, 1, false);
+	PlayerLocations.RemoveAtSwap(PlayerIndex, 1, false);
+	LastLocalNoiseTimes.RemoveAtSwap(PlayerIndex, 1, false);
+	LastRemoteNoiseTimes.RemoveAtSwap(PlayerIndex, 1, false);
+	if (Players.IsValidIndex(PlayerIndex))
+	{
+		Players[PlayerIndex]->PerceptionIndex = PlayerIndex;
+	}
+	Player->PerceptionIndex = INDEX_NONE;
+}
+
+FIntVector UBossPerceptionSubsystem::GetCell(const FVector& Location)
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), 0);
+}
+
+void UBossPerceptionSubsystem::BuildSpatialHash()
+{
+	// Keep the cell arrays between frames unless the hash grew far beyond what is populated
+	if (PlayerCells.Num() > 4 * (Players.Num() + 16))
+	{
+		PlayerCells.Reset();
+	}
+	if (BossCells.Num() > 4 * (Bosses.Num() + 16))
+	{
+		BossCells.Reset();
+	}
+	for (TPair<FIntVector, TArray<int32, TInlineAllocator<4>>>& Cell : PlayerCells)
+	{
+		Cell.Value.Reset();
+	}
+	for (TPair<FIntVector, TArray<int32, TInlineAllocator<4>>>& Cell : BossCells)
+	{
+		Cell.Value.Reset();
+	}
+
+	for (int32 PlayerIndex = 0; PlayerIndex < Players.Num(); PlayerIndex++)
+	{
+		PlayerLocations[PlayerIndex] = Players[PlayerIndex]->GetActorLocation();
+		PlayerCells.FindOrAdd(GetCell(PlayerLocations[PlayerIndex])).Add(PlayerIndex);
+	}
+	for (int32 BossIndex = 0; BossIndex < Bosses.Num(); BossIndex++)
+	{
+		BossLocations[BossIndex] = Bosses[BossIndex]->GetActorLocation();
+		BossCells.FindOrAdd(GetCell(BossLocations[BossIndex])).Add(BossIndex);
+	}
+}
+
+template<typename VisitorType>
+void UBossPerceptionSubsystem::ForEachPlayerInRadius(const FVector& Center, float Radius, VisitorType&& Visitor) const
+{
+	const FIntVector MinCell = GetCell(Center - FVector(Radius, Radius, 0.f));
+	const FIntVector MaxCell = GetCell(Center + FVector(Radius, Radius, 0.f));
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			if (const TArray<int32, TInlineAllocator<4>>* Cell = PlayerCells.Find(FIntVector(X, Y, 0)))
+			{
+				for (const int32 PlayerIndex : *Cell)
+				{
+					Visitor(PlayerIndex);
+				}
+			}
+		}
+	}
+}
+
+template<typename VisitorType>
+void UBossPerceptionSubsystem::ForEachBossInRadius(const FVector& Center, float Radius, VisitorType&& Visitor) const
+{
+	const FIntVector MinCell = GetCell(Center - FVector(Radius, Radius, 0.f));
+	const FIntVector MaxCell = GetCell(Center + FVector(Radius, Radius, 0.f));
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			if (const TArray<int32, TInlineAllocator<4>>* Cell = BossCells.Find(FIntVector(X, Y, 0)))
+			{
+				for (const int32 BossIndex : *Cell)
+				{
+					Visitor(BossIndex);
+				}
+			}
+		}
+	}
+}
+
+bool UBossPerceptionSubsystem::ConsumeTrace()
+{
+	if (TracesLeft <= 0)
+	{
+		return false;
+	}
+	TracesLeft--;
+	return true;
+}
+
+bool UBossPerceptionSubsystem::HasLineOfSight(const AActor* From, const FVector& FromLocation, const AActor* To, const FVector& ToLocation) const
+{
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(BossPerceptionLineOfSight), true, From);
+	Params.AddIgnoredActor(To);
+	return !GetWorld()->LineTraceTestByChannel(FromLocation, ToLocation, ECC_Visibility, Params);
+}
+
+bool UBossPerceptionSubsystem::SenseBoss(int32 BossIndex, double Now)
+{
+	AAICharacter* Boss = Bosses[BossIndex];
+	const FVector& BossLocation = BossLocations[BossIndex];
+	const FVector Forward = Boss->GetActorForwardVector();
+	const float SightRadius = SightRadii[BossIndex];
+	const float SightRadiusSquared = FMath::Square(SightRadius);
+	const float PeripheralVisionCosine = PeripheralVisionCosines[BossIndex];
+
+	// Candidates in range and in the field of view, nearest first
+	TArray<TPair<float, int32>, TInlineAllocator<8>> Candidates;
+	ForEachPlayerInRadius(BossLocation, SightRadius, [&](int32 PlayerIndex)
+	{
+		const FVector ToPlayer = PlayerLocations[PlayerIndex] - BossLocation;
+		const float DistanceSquared = ToPlayer.SizeSquared();
+		if (DistanceSquared <= SightRadiusSquared && (ToPlayer.GetSafeNormal() | Forward) >= PeripheralVisionCosine)
+		{
+			Candidates.Emplace(DistanceSquared, PlayerIndex);
+		}
+	});
+	Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	const FVector EyeLocation = Boss->GetPawnViewLocation();
+	for (const TPair<float, int32>& Candidate : Candidates)
+	{
+		if (!ConsumeTrace())
+		{
+			return false;
+		}
+		if (HasLineOfSight(Boss, EyeLocation, Players[Candidate.Value], PlayerLocations[Candidate.Value]))
+		{
+			NoteEngaged(BossIndex, Now);
+			Stimuli.Add({ BossIndex, Candidate.Value, PlayerLocations[Candidate.Value], 1.f, true });
+			break;
+		}
+	}
+
+	NextSenseTimes[BossIndex] = Now + SensingIntervals[BossIndex] * FBossLODSettings::SenseIntervalScales[(int32)LODs[BossIndex]];
+	return true;
+}
+
+void UBossPerceptionSubsystem::ProcessNoises(double Now)
+{
+	// Hearings the trace budget left over go first, like bosses left unsensed
+	int32 NumDone = 0;
+	for (; NumDone < PendingHearings.Num(); NumDone++)
+	{
+		const FPendingHearing& Hearing = PendingHearings[NumDone];
+		AAICharacter* Boss = Hearing.Boss.Get();
+		ABossFightCharacter* Player = Hearing.Player.Get();
+		const bool bRegistered = Boss && Player && Bosses.IsValidIndex(Boss->PerceptionIndex) && Bosses[Boss->PerceptionIndex] == Boss
+			&& Players.IsValidIndex(Player->PerceptionIndex) && Players[Player->PerceptionIndex] == Player;
+		if (!bRegistered || Now - Hearing.Time > MaxHearingDelay)
+		{
+			continue;
+		}
+		if (!ConsumeTrace())
+		{
+			break;
+		}
+		if (HasLineOfSight(Boss, Boss->GetPawnViewLocation(), Player, Hearing.Location))
+		{
+			NoteEngaged(Boss->PerceptionIndex, Now);
+			Stimuli.Add({ Boss->PerceptionIndex, Player->PerceptionIndex, Hearing.Location, Hearing.Volume, false });
+		}
+	}
+	PendingHearings.RemoveAt(0, NumDone, false);
+
+	for (int32 PlayerIndex = 0; PlayerIndex < Players.Num(); PlayerIndex++)
+	{
+		ABossFightCharacter* Player = Players[PlayerIndex];
+		const UPawnNoiseEmitterComponent* NoiseEmitter = Player->GetPawnNoiseEmitterComponent();
+		if (!NoiseEmitter)
+		{
+			continue;
+		}
+
+		// Like pawn sensing, a noise is heard at the location of the pawn that emitted it
+		for (const bool bLocal : { true, false })
+		{
+			float& LastNoiseTime = bLocal ? LastLocalNoiseTimes[PlayerIndex] : LastRemoteNoiseTimes[PlayerIndex];
+			const float NoiseTime = NoiseEmitter->GetLastNoiseTime(bLocal);
+			if (NoiseTime <= LastNoiseTime)
+			{
+				continue;
+			}
+			LastNoiseTime = NoiseTime;
+
+			const float Volume = NoiseEmitter->GetLastNoiseVolume(bLocal);
+			const FVector& NoiseLocation = PlayerLocations[PlayerIndex];
+			ForEachBossInRadius(NoiseLocation, MaxLOSHearingThreshold * Volume, [&](int32 BossIndex)
+			{
+				const float DistanceSquared = FVector::DistSquared(BossLocations[BossIndex], NoiseLocation);
+				if (DistanceSquared > FMath::Square(HearingThresholds[BossIndex] * Volume))
+				{
+					if (DistanceSquared > FMath::Square(LOSHearingThresholds[BossIndex] * Volume))
+					{
+						return;
+					}
+					// The noise is routed once, a boss that needs a trace the frame cannot afford hears it next frame
+					if (!ConsumeTrace())
+					{
+						PendingHearings.Add({ Bosses[BossIndex], Player, NoiseLocation, Volume, Now });
+						return;
+					}
+					if (!HasLineOfSight(Bosses[BossIndex], Bosses[BossIndex]->GetPawnViewLocation(), Player, NoiseLocation))
+					{
+						return;
+					}
+				}
+				NoteEngaged(BossIndex, Now);
+				Stimuli.Add({ BossIndex, PlayerIndex, NoiseLocation, Volume, false });
+			});
+		}
+	}
+}
+
+void UBossPerceptionSubsystem::NoteEngaged(int32 BossIndex, double Now)
+{
+	if (LODs.IsValidIndex(BossIndex))
+	{
+		LastEngagedTimes[BossIndex] = Now;
+		SetBossLOD(BossIndex, EBossLOD::Engaged);
+	}
+}
+
+EBossLOD UBossPerceptionSubsystem::EvaluateLOD(int32 BossIndex, double Now) const
+{
+	if (Bosses[BossIndex]->collision || Now - LastEngagedTimes[BossIndex] < EngagedMemory)
+	{
+		return EBossLOD::Engaged;
+	}
+
+	// Far bosses have to come within LODNearDistance, the others leave beyond the margin
+	const float Range = LODs[BossIndex] == EBossLOD::Far ? LODNearDistance : LODNearDistance + LODHysteresis;
+	const float RangeSquared = FMath::Square(Range);
+	const FVector& BossLocation = BossLocations[BossIndex];
+	bool bPlayerInRange = false;
+	ForEachPlayerInRadius(BossLocation, Range, [&](int32 PlayerIndex)
+	{
+		bPlayerInRange |= FVector::DistSquared(PlayerLocations[PlayerIndex], BossLocation) <= RangeSquared;
+	});
+	return bPlayerInRange ? EBossLOD::Near : EBossLOD::Far;
+}
+
+void UBossPerceptionSubsystem::SetBossLOD(int32 BossIndex, EBossLOD NewLOD)
+{
+	EBossLOD& LOD = LODs[BossIndex];
+	if (LOD == NewLOD)
+	{
+		return;
+	}
+	LODCounts[(int32)LOD]--;
+	LODCounts[(int32)NewLOD]++;
+	// A boss leaving Far should not wait out its long sensing interval
+	if (NewLOD < LOD)
+	{
+		NextSenseTimes[BossIndex] = FMath::Min(NextSenseTimes[BossIndex], GetWorld()->GetTimeSeconds() + SensingIntervals[BossIndex]);
+	}
+	LOD = NewLOD;
+	Bosses[BossIndex]->SetLOD(NewLOD);
+}
+
+void UBossPerceptionSubsystem::UpdateLODs(double Now)
+{
+	const int32 NumBosses = Bosses.Num();
+	const int32 NumUpdates = FMath::Min(NumBosses, MaxLODUpdatesPerFrame);
+	LODCursor = LODCursor < NumBosses ? LODCursor : 0;
+	for (int32 Step = 0; Step < NumUpdates; Step++)
+	{
+		const int32 BossIndex = (LODCursor + Step) % NumBosses;
+		SetBossLOD(BossIndex, EvaluateLOD(BossIndex, Now));
+	}
+	LODCursor = (LODCursor + NumUpdates) % NumBosses;
+
+	FBossFightStats::SetBossLODCounts(LODCounts[(int32)EBossLOD::Engaged], LODCounts[(int32)EBossLOD::Near], LODCounts[(int32)EBossLOD::Far]);
+}
+
+void UBossPerceptionSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UBossPerceptionSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	if (Bosses.Num() == 0)
+	{
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	TracesLeft = MaxTracesPerFrame;
+	BuildSpatialHash();
+	// Without players every boss drifts to Far, there is nothing to sense
+	UpdateLODs(Now);
+	if (Players.Num() == 0)
+	{
+		return;
+	}
+	ProcessNoises(Now);
+	SenseBosses(Now);
+	DispatchStimuli();
+}
+
+void UBossPerceptionSubsystem::SenseBosses(double Now)
+{
+	// Round robin from where the budget ran out last frame so every boss gets its turn
+	const int32 NumBosses = Bosses.Num();
+	SenseCursor = SenseCursor < NumBosses ? SenseCursor : 0;
+	for (int32 Step = 0; Step < NumBosses; Step++)
+	{
+		const int32 BossIndex = (SenseCursor + Step) % NumBosses;
+		if (Now < NextSenseTimes[BossIndex])
+		{
+			continue;
+		}
+		if (!SenseBoss(BossIndex, Now))
+		{
+			SenseCursor = BossIndex;
+			return;
+		}
+	}
+	SenseCursor = 0;
+}
+
+void UBossPerceptionSubsystem::DispatchStimuli()
+{
+	const int32 NumRaw = Stimuli.Num();
+	if (NumRaw == 0)
+	{
+		return;
+	}
+
+	// Per boss the player it already reacts to comes first, then sightings, then the loudest noise
+	Stimuli.Sort([this](const FStimulus& A, const FStimulus& B)
+	{
+		if (A.BossIndex != B.BossIndex)
+		{
+			return A.BossIndex < B.BossIndex;
+		}
+		const ABossFightCharacter* Target = StimulusTargets[A.BossIndex].Get();
+		const bool bTargetA = Players[A.PlayerIndex] == Target;
+		const bool bTargetB = Players[B.PlayerIndex] == Target;
+		if (bTargetA != bTargetB)
+		{
+			return bTargetA;
+		}
+		if (A.bSeen != B.bSeen)
+		{
+			return A.bSeen;
+		}
+		return A.Volume > B.Volume;
+	});
+
+	DueStimuli.Reset();
+	for (int32 Index = 0; Index < NumRaw; Index++)
+	{
+		const FStimulus& Stimulus = Stimuli[Index];
+		if (Index > 0 && Stimuli[Index - 1].BossIndex == Stimulus.BossIndex)
+		{
+			continue;
+		}
+		const int32 BossIndex = Stimulus.BossIndex;
+		AAICharacter* Boss = Bosses[BossIndex];
+		ABossFightCharacter* Player = Players[Stimulus.PlayerIndex];
+		const bool bChanged = StimulusTargets[BossIndex].Get() != Player || !Boss->IsPursuing()
+			|| FVector::DistSquared(StimulusLocations[BossIndex], Stimulus.Location) > FMath::Square(StimulusMoveThreshold);
+		if (bChanged)
+		{
+			StimulusTargets[BossIndex] = Player;
+			StimulusLocations[BossIndex] = Stimulus.Location;
+		}
+		DueStimuli.Add({ Boss, Player, Stimulus.Location, Stimulus.Volume, Stimulus.bSeen, bChanged });
+	}
+	Stimuli.Reset();
+	FBossFightStats::AddPerceptionStimuli(NumRaw, DueStimuli.Num());
+
+	for (const FDueStimulus& Due : DueStimuli)
+	{
+		if (!Due.bChanged)
+		{
+			Due.Boss->KeepPursuing();
+		}
+		else if (Due.bSeen)
+		{
+			FBossFightStats::NotePerceptionEvent();
+			Due.Boss->SeePawn(Due.Player);
+		}
+		else
+		{
+			FBossFightStats::NotePerceptionEvent();
+			Due.Boss->OnHearNoise(Due.Player, Due.Location, Due.Volume);
+		}
+	}
+}
+
+TStatId UBossPerceptionSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_PerceptionTick);
+}
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BossPerceptionSubsystem.generated.h"
+
+class AAICharacter;
+class ABossFightCharacter;
+
+/** Update fidelity of a boss, from fighting someone down to far from every player */
+enum class EBossLOD : uint8
+{
+	/** Saw, heard or touched a player recently */
+	Engaged,
+	/** A player is within LODNearDistance */
+	Near,
+	Far,
+
+	Count
+};
+
+/** Cost knobs of each EBossLOD, indexed by the tier */
+struct FBossLODSettings
+{
+	/** Multiplies the sensing interval of the boss */
+	static constexpr float SenseIntervalScales[] = { 1.f, 2.f, 6.f };
+	/** Multiplies UBossBrainSubsystem::RoamInterval */
+	static constexpr float RoamIntervalScales[] = { 1.f, 2.f, 5.f };
+	/** Tick interval of the movement, mesh and controller of the boss, 0 for every frame */
+	static constexpr float TickIntervals[] = { 0.f, 0.1f, 0.25f };
+};
+
+/**
+ * Sight and hearing for every boss of the world.
+ * Players and bosses are bucketed in a uniform 2D spatial hash, so a boss only looks at the players of
+ * nearby cells. All bosses are sensed in one pass per frame with a fixed budget of line of sight traces;
+ * bosses and noise hearings that did not fit in the budget are picked up first on the next frame.
+ * Sightings and noises of a frame are buffered and coalesced to one stimulus per boss before the bosses hear about
+ * them; a boss is only told again when its target changed or moved meaningfully, repeats just keep it chasing.
+ * The same pass rates the significance of the bosses: a budgeted round robin puts each boss in an EBossLOD tier from
+ * its engagement and the distance to the nearest player, with a distance margin so bosses on a border do not flicker.
+ */
+UCLASS()
+class BOSSFIGHT_API UBossPerceptionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Edge length of a spatial hash cell */
+	static constexpr float CellSize = 2500.f;
+	/** Line of sight traces allowed per frame for all bosses together */
+	static constexpr int32 MaxTracesPerFrame = 64;
+	/** Bosses whose tier is evaluated per frame */
+	static constexpr int32 MaxLODUpdatesPerFrame = 32;
+	/** Bosses closer than this to a player are Near, they only go Far again beyond LODNearDistance + LODHysteresis */
+	static constexpr float LODNearDistance = 6000.f;
+	static constexpr float LODHysteresis = 1000.f;
+	/** Seconds a boss stays Engaged after it last sensed or touched a player */
+	static constexpr float EngagedMemory = 5.f;
+	/** Seconds a noise that needs a line of sight trace waits for the trace budget before the boss misses it */
+	static constexpr float MaxHearingDelay = 0.5f;
+	/** A boss only reacts again to the player it reacted to once the player moved this far, it keeps chasing otherwise */
+	static constexpr float StimulusMoveThreshold = 300.f;
+
+	void RegisterBoss(AAICharacter* Boss);
+	void UnregisterBoss(AAICharacter* Boss);
+	void RegisterPlayer(ABossFightCharacter* Player);
+	void UnregisterPlayer(ABossFightCharacter* Player);
+
+	/** Puts a boss that is fighting someone at full rate right away */
+	void NoteEngaged(int32 BossIndex, double Now);
+	/** Bosses currently in a tier */
+	FORCEINLINE int32 NumBossesInLOD(EBossLOD LOD) const { return LODCounts[(int32)LOD]; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Rebuilds the spatial hash from the current actor locations */
+	void BuildSpatialHash();
+	/** Calls Visitor with the index of every player in the cells overlapping the circle */
+	template<typename VisitorType>
+	void ForEachPlayerInRadius(const FVector& Center, float Radius, VisitorType&& Visitor) const;
+	template<typename VisitorType>
+	void ForEachBossInRadius(const FVector& Center, float Radius, VisitorType&& Visitor) const;
+	/** Returns false when the trace budget of the frame is spent */
+	bool ConsumeTrace();
+	bool HasLineOfSight(const AActor* From, const FVector& FromLocation, const AActor* To, const FVector& ToLocation) const;
+
+	/** Senses the bosses that are due, round robin under the trace budget */
+	void SenseBosses(double Now);
+	/** Looks for the nearest visible player of a boss, returns false if it ran out of traces */
+	bool SenseBoss(int32 BossIndex, double Now);
+	/** Routes the noises players made since the last frame to the bosses in hearing range */
+	void ProcessNoises(double Now);
+	/** Coalesces the stimuli of the frame and hands the ones that matter to the bosses */
+	void DispatchStimuli();
+	/** Re-rates the next MaxLODUpdatesPerFrame bosses */
+	void UpdateLODs(double Now);
+	EBossLOD EvaluateLOD(int32 BossIndex, double Now) const;
+	void SetBossLOD(int32 BossIndex, EBossLOD NewLOD);
+
+	static FIntVector GetCell(const FVector& Location);
+
+	UPROPERTY()
+	TArray<AAICharacter*> Bosses;
+	/** Per boss sensing state and settings, copied from the boss when it registers */
+	TArray<FVector> BossLocations;
+	TArray<double> NextSenseTimes;
+	TArray<float> SightRadii;
+	TArray<float> PeripheralVisionCosines;
+	TArray<float> HearingThresholds;
+	TArray<float> LOSHearingThresholds;
+	TArray<float> SensingIntervals;
+	TArray<EBossLOD> LODs;
+	/** Last time each boss sensed or touched a player */
+	TArray<double> LastEngagedTimes;
+	/** Player and location of the last stimulus each boss reacted to */
+	TArray<TWeakObjectPtr<ABossFightCharacter>> StimulusTargets;
+	TArray<FVector> StimulusLocations;
+	int32 LODCounts[(int32)EBossLOD::Count] = {};
+	/** Largest hearing range of all bosses that ever registered, bounds the hash query of a noise */
+	float MaxLOSHearingThreshold = 0.f;
+
+	UPROPERTY()
+	TArray<ABossFightCharacter*> Players;
+	TArray<FVector> PlayerLocations;
+	/** Last noise of each player that was already routed, local and remote */
+	TArray<float> LastLocalNoiseTimes;
+	TArray<float> LastRemoteNoiseTimes;
+
+	/** A noise a boss could only hear in sight, waiting for the trace budget of a later frame */
+	struct FPendingHearing
+	{
+		TWeakObjectPtr<AAICharacter> Boss;
+		TWeakObjectPtr<ABossFightCharacter> Player;
+		FVector Location;
+		float Volume;
+		double Time;
+	};
+	TArray<FPendingHearing> PendingHearings;
+
+	TMap<FIntVector, TArray<int32, TInlineAllocator<4>>> PlayerCells;
+	TMap<FIntVector, TArray<int32, TInlineAllocator<4>>> BossCells;
+
+	/** A boss saw or heard a player this frame, only buffered within Tick so the indices stay valid */
+	struct FStimulus
+	{
+		int32 BossIndex;
+		int32 PlayerIndex;
+		FVector Location;
+		float Volume;
+		bool bSeen;
+	};
+	TArray<FStimulus> Stimuli;
+
+	/** Coalesced stimulus of one boss, kept as pointers since the callbacks may change the indices */
+	struct FDueStimulus
+	{
+		AAICharacter* Boss;
+		ABossFightCharacter* Player;
+		FVector Location;
+		float Volume;
+		bool bSeen;
+		/** New target or the target moved, the boss reacts; otherwise it only keeps chasing */
+		bool bChanged;
+	};
+	TArray<FDueStimulus> DueStimuli;
+
+	/** Boss the next frame starts sensing from */
+	int32 SenseCursor = 0;
+	/** Boss the next frame starts rating from */
+	int32 LODCursor = 0;
+	int32 TracesLeft = 0;
+};
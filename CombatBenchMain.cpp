@@ -0,0 +1,522 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Microbenchmarks of the combat hot paths, built outside the engine:
+//	g++ -std=c++17 -O2 CombatBenchMain.cpp -o CombatBench
+//	./CombatBench --out=bench.json
+// Every benchmark runs at 1, 100 and 10000 characters and reports ns/op, timers registered and heap allocations
+// as one JSON object per line. The "legacy" benchmarks model the per-second FTimerManager chains the actors used
+// before, with a binary heap standing in for the timer manager, so both designs can be compared on one build.
+// The engine build skips this file.
+
+#if !defined(WITH_ENGINE)
+
+#include "CombatEventLog.h"
+#include "CombatSimulator.h"
+#include "DamageResolver.h"
+#include "FighterAttributes.h"
+#include "FlowField.h"
+#include "SkillExecutor.h"
+#include "StatusEffects.h"
+#include "ThreatTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::atomic<uint64> GAllocations(0);
+}
+
+void* operator new(std::size_t Size)
+{
+	GAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* Pointer = std::malloc(Size ? Size : 1))
+	{
+		return Pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* Pointer) noexcept
+{
+	std::free(Pointer);
+}
+
+void operator delete(void* Pointer, std::size_t) noexcept
+{
+	std::free(Pointer);
+}
+
+namespace
+{
+	/** Minimal stand-in for FTimerManager: a min-heap of due times */
+	struct FTimerHeap
+	{
+		struct FTimer
+		{
+			double DueTime;
+			int32 Owner;
+			int32 Kind;
+			bool operator>(const FTimer& Other) const { return DueTime > Other.DueTime; }
+		};
+
+		void SetTimer(double DueTime, int32 Owner, int32 Kind)
+		{
+			Timers.push({ DueTime, Owner, Kind });
+			Registered++;
+		}
+
+		std::priority_queue<FTimer, std::vector<FTimer>, std::greater<FTimer>> Timers;
+		uint64 Registered = 0;
+	};
+
+	struct FBenchResult
+	{
+		std::string Name;
+		int32 Characters = 0;
+		uint64 Ops = 0;
+		double NanosecondsPerOp = 0.0;
+		uint64 TimersRegistered = 0;
+		uint64 Allocations = 0;
+	};
+
+	/**
+	 * Calls Body (which performs one batch over all characters and adds the ops done and timers registered)
+	 * until at least MinSeconds have elapsed.
+	 */
+	FBenchResult Measure(const char* Name, int32 Characters, const std::function<void(uint64&, uint64&)>& Body)
+	{
+		constexpr double MinSeconds = 0.05;
+
+		FBenchResult Result;
+		Result.Name = Name;
+		Result.Characters = Characters;
+
+		// Warm up once so first-touch allocations of the body are not counted
+		uint64 WarmupOps = 0;
+		uint64 WarmupTimers = 0;
+		Body(WarmupOps, WarmupTimers);
+
+		// Batch small character counts so the clock is not read more often than the body runs
+		const int32 Repeats = Characters < 10000 ? 10000 / Characters : 1;
+		const uint64 AllocationsBefore = GAllocations.load();
+		const auto Start = std::chrono::steady_clock::now();
+		double Elapsed = 0.0;
+		do
+		{
+			for (int32 Repeat = 0; Repeat < Repeats; Repeat++)
+			{
+				Body(Result.Ops, Result.TimersRegistered);
+			}
+			Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+		while (Elapsed < MinSeconds);
+
+		Result.Allocations = GAllocations.load() - AllocationsBefore;
+		Result.NanosecondsPerOp = Result.Ops ? Elapsed * 1e9 / (double)Result.Ops : 0.0;
+		return Result;
+	}
+
+	std::vector<FSimFighter> MakeFighters(int32 Count)
+	{
+		std::vector<FSimFighter> Fighters((size_t)Count);
+		for (FSimFighter& Fighter : Fighters)
+		{
+			Fighter.Health = Fighter.MaxHealth = FFighterDefaults::BossMaxHealth;
+			Fighter.AbilityPoint = FRegeneratingAttribute(FFighterDefaults::MaxAbilityPoint, FFighterDefaults::MaxAbilityPoint, FFighterDefaults::AbilityPointRegenRate, 0.0);
+		}
+		for (size_t Index = 0; Index < Fighters.size(); Index++)
+		{
+			Fighters[Index].Target = &Fighters[(Index + 1) % Fighters.size()];
+		}
+		return Fighters;
+	}
+
+	/** Keeps the optimizer from dropping results */
+	volatile float GSink = 0.f;
+
+	void RunAll(int32 Characters, std::vector<FBenchResult>& OutResults)
+	{
+		FSkillTable Skills;
+		Skills.Assign(GBossDefaultSkills);
+		std::vector<FSimFighter> Fighters = MakeFighters(Characters);
+		double Now = 0.0;
+
+		OutResults.push_back(Measure("skill_execute", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			for (size_t Index = 0; Index < Fighters.size(); Index++)
+			{
+				FSimFighter& Fighter = Fighters[Index];
+				Fighter.Now = Now;
+				Fighter.Target->Health = FFighterDefaults::BossMaxHealth;
+				Fighter.AbilityPoint.Set(FFighterDefaults::MaxAbilityPoint, Now);
+				TSkillExecutor<FSimFighter>::Execute(Fighter, Skills[(int32)(Index % Skills.Num())], Now);
+			}
+			Ops += Fighters.size();
+		}));
+
+		OutResults.push_back(Measure("cooldown_query", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			float Remaining = 0.f;
+			for (const FSimFighter& Fighter : Fighters)
+			{
+				for (int32 Slot = 0; Slot < (int32)ECooldownSlot::Count; Slot++)
+				{
+					Remaining += Fighter.Cooldowns.GetRemaining(Slot, Now);
+				}
+			}
+			GSink = Remaining;
+			Ops += Fighters.size() * (size_t)ECooldownSlot::Count;
+		}));
+
+		// One simulated second of three running cooldowns per character, each re-armed every second
+		OutResults.push_back(Measure("cooldown_legacy_timers", Characters, [&](uint64& Ops, uint64& Timers)
+		{
+			FTimerHeap Heap;
+			int32 Remaining = 0;
+			for (int32 Owner = 0; Owner < Characters; Owner++)
+			{
+				for (int32 Kind = 0; Kind < 3; Kind++)
+				{
+					Heap.SetTimer(1.0, Owner, Kind);
+				}
+			}
+			while (!Heap.Timers.empty() && Heap.Timers.top().DueTime <= 1.0)
+			{
+				const FTimerHeap::FTimer Timer = Heap.Timers.top();
+				Heap.Timers.pop();
+				Remaining++;
+				Heap.SetTimer(Timer.DueTime + 1.0, Timer.Owner, Timer.Kind);
+			}
+			GSink = (float)Remaining;
+			Ops += (uint64)Characters * 3;
+			Timers += Heap.Registered;
+		}));
+
+		OutResults.push_back(Measure("ap_regen_read", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			float Total = 0.f;
+			for (const FSimFighter& Fighter : Fighters)
+			{
+				Total += Fighter.AbilityPoint.Get(Now);
+			}
+			GSink = Total;
+			Ops += Fighters.size();
+		}));
+
+		// One simulated second of the 0.1 s "AP full" polling loop per character
+		OutResults.push_back(Measure("ap_regen_legacy_timers", Characters, [&](uint64& Ops, uint64& Timers)
+		{
+			FTimerHeap Heap;
+			for (int32 Owner = 0; Owner < Characters; Owner++)
+			{
+				Heap.SetTimer(0.1, Owner, 0);
+			}
+			while (!Heap.Timers.empty() && Heap.Timers.top().DueTime <= 1.0)
+			{
+				const FTimerHeap::FTimer Timer = Heap.Timers.top();
+				Heap.Timers.pop();
+				Heap.SetTimer(Timer.DueTime + 0.1, Timer.Owner, Timer.Kind);
+			}
+			Ops += (uint64)Characters;
+			Timers += Heap.Registered;
+		}));
+
+		// What BeginOverlap does for every boss: engage, roll a skill and store its impact time
+		std::vector<int32> PendingSkills(Fighters.size(), INDEX_NONE);
+		std::vector<double> ImpactTimes(Fighters.size(), 0.0);
+		FCombatRandom Random(1);
+		OutResults.push_back(Measure("overlap_begin", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			for (size_t Index = 0; Index < Fighters.size(); Index++)
+			{
+				const FSimFighter& Fighter = Fighters[Index];
+				const int32 SkillId = TSkillExecutor<FSimFighter>::ChooseSkill(Fighter, Skills, Random.RandRange(0, Skills.Num() - 1), Now);
+				PendingSkills[Index] = SkillId;
+				ImpactTimes[Index] = Now + Skills[SkillId].WindUp;
+			}
+			Ops += Fighters.size();
+		}));
+
+		OutResults.push_back(Measure("ai_skill_selection", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			int32 Sum = 0;
+			for (const FSimFighter& Fighter : Fighters)
+			{
+				Sum += TSkillExecutor<FSimFighter>::ChooseSkill(Fighter, Skills, Random.RandRange(0, Skills.Num() - 1), Now);
+			}
+			GSink = (float)Sum;
+			Ops += Fighters.size();
+		}));
+
+		// A frame where every character lands four hits on random targets, resolved in one pass
+		std::vector<FDamageHit> Hits((size_t)Characters * 4);
+		std::vector<float> Health((size_t)Characters, 0.f);
+		std::vector<float> PendingDamage((size_t)Characters, 0.f);
+		std::vector<uint8> Died((size_t)Characters, 0);
+		std::vector<int32> Deaths((size_t)Characters, 0);
+		for (size_t HitIndex = 0; HitIndex < Hits.size(); HitIndex++)
+		{
+			Hits[HitIndex] = { Random.RandRange(0, Characters - 1), 5.f, (uint32)(HitIndex / 4) };
+		}
+		OutResults.push_back(Measure("damage_resolve", Characters, [&](uint64& Ops, uint64&)
+		{
+			for (float& Value : Health)
+			{
+				Value = FFighterDefaults::BossMaxHealth;
+			}
+			FDamageResolver::Accumulate(Hits.data(), (int32)Hits.size(), PendingDamage.data());
+			FDamageResolver::Apply(Health.data(), PendingDamage.data(), Died.data(), Characters);
+			GSink = (float)FDamageResolver::GatherDeaths(Died.data(), Characters, Deaths.data());
+			Ops += Hits.size();
+		}));
+
+		OutResults.push_back(Measure("combat_event_log", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			for (size_t Index = 0; Index < Fighters.size(); Index++)
+			{
+				COMBAT_LOG_EVENT(Now, (uint32)Index, ECombatEventType::SkillCast, 1.f, Fighters[Index].Health);
+			}
+			Ops += Fighters.size();
+		}));
+
+		// A frame where every fourth character takes a hit, then the changes are published for replication and UI.
+		// "legacy" compares every field with the last published copy, the others take the dirty masks.
+		std::vector<FSimFighter> Published = Fighters;
+		OutResults.push_back(Measure("attribute_publish_legacy", Characters, [&](uint64& Ops, uint64&)
+		{
+			Now += 0.1;
+			for (size_t Index = 0; Index < Fighters.size(); Index += 4)
+			{
+				Fighters[Index].Health -= 1.f;
+			}
+			int32 Changed = 0;
+			for (size_t Index = 0; Index < Fighters.size(); Index++)
+			{
+				const FSimFighter& Fighter = Fighters[Index];
+				FSimFighter& Last = Published[Index];
+				bool bChanged = Fighter.Health != Last.Health || Fighter.AbilityPoint.Get(Now) != Last.AbilityPoint.Get(Now);
+				for (int32 Slot = 0; Slot < FCooldownTracker::MaxSlots; Slot++)
+				{
+					bChanged |= Fighter.Cooldowns.GetExpiryTime(Slot) != Last.Cooldowns.GetExpiryTime(Slot);
+				}
+				if (bChanged)
+				{
+					Last = Fighter;
+					Changed++;
+				}
+			}
+			GSink = (float)Changed;
+			Ops += Fighters.size();
+		}));
+
+		std::vector<FFighterAttributes> AttributeBlocks((size_t)Characters, FFighterAttributes(FFighterDefaults::BossMaxHealth, 10.f, FFighterDefaults::MaxAbilityPoint, FFighterDefaults::AbilityPointRegenRate, 0.f, 0.f, 0.0));
+		OutResults.push_back(Measure("attribute_publish", Characters, [&](uint64& Ops, uint64&)
+		{
+			for (size_t Index = 0; Index < AttributeBlocks.size(); Index += 4)
+			{
+				AttributeBlocks[Index].SetHealth(AttributeBlocks[Index].GetHealth() - 1.f);
+			}
+			uint32 Changed = 0;
+			for (FFighterAttributes& Attributes : AttributeBlocks)
+			{
+				Changed |= Attributes.TakeDirtyMask();
+			}
+			GSink = (float)Changed;
+			Ops += AttributeBlocks.size();
+		}));
+
+		// A frame of pursuit: the player walks one cell, the field of the player gets the per-frame cell budget of
+		// UPursuitSubsystem and every boss reads its next step. The field is shared, so the cost per boss falls as
+		// the bosses grow in number instead of adding a path search per boss.
+		typedef TFlowField<96> FBenchField;
+		std::unique_ptr<FBenchField> Field(new FBenchField());
+		for (int32 Y = 0; Y < FBenchField::Size; Y++)
+		{
+			for (int32 X = 0; X < FBenchField::Size; X++)
+			{
+				// Pillars every 8 cells and a wall with a gap across the middle
+				const bool bBlocked = (X % 8 == 4 && Y % 8 == 4) || (Y == FBenchField::Size / 2 && X > 8);
+				Field->SetCell(X, Y, !bBlocked, 0.f);
+			}
+		}
+		std::vector<int32> BossCells((size_t)Characters);
+		for (int32 Index = 0; Index < Characters; Index++)
+		{
+			BossCells[(size_t)Index] = (int32)(((uint32)Index * 2654435761u) % (uint32)FBenchField::NumCells);
+		}
+		int32 PlayerX = 0;
+		OutResults.push_back(Measure("pursuit_flow_field", Characters, [&](uint64& Ops, uint64&)
+		{
+			PlayerX = (PlayerX + 1) % FBenchField::Size;
+			if (!Field->IsBuilding())
+			{
+				Field->BeginBuild(PlayerX, FBenchField::Size / 4, 60.f);
+			}
+			int32 Budget = 4096;
+			Field->ContinueBuild(Budget);
+			int32 Steps = 0;
+			for (const int32 Cell : BossCells)
+			{
+				const uint8 Direction = Field->GetDirection(Cell % FBenchField::Size, Cell / FBenchField::Size);
+				Steps += FBenchField::GetStepX(Direction) + FBenchField::GetStepY(Direction);
+			}
+			GSink = (float)Steps;
+			Ops += BossCells.size();
+		}));
+
+		// A frame of raid threat: the characters attack in raids of 40 per boss, every attacker adds threat to the
+		// table of its boss and every boss reads its top target, like the skills of UThreatSubsystem bosses do.
+		typedef TThreatTable<64> FBenchThreatTable;
+		constexpr int32 RaidSize = 40;
+		std::vector<FBenchThreatTable> ThreatTables((size_t)((Characters + RaidSize - 1) / RaidSize));
+		uint32 ThreatSeed = 1;
+		OutResults.push_back(Measure("threat_table", Characters, [&](uint64& Ops, uint64&)
+		{
+			int32 Targets = 0;
+			for (int32 Index = 0; Index < Characters; Index++)
+			{
+				ThreatSeed = ThreatSeed * 1664525u + 1013904223u;
+				ThreatTables[(size_t)(Index / RaidSize)].AddThreat(Index % RaidSize, (float)(ThreatSeed >> 24));
+			}
+			for (const FBenchThreatTable& Table : ThreatTables)
+			{
+				Targets += Table.GetTop();
+			}
+			GSink = (float)Targets;
+			Ops += (uint64)Characters;
+		}));
+
+		// A frame of buffs and debuffs at the 20 Hz clock of UStatusEffectSubsystem: every character gets a damage over
+		// time (a tick every 0.25 s) and a slow of 1 to 3 s once per second, so about four effects per character are
+		// alive and a share of them ticks or expires every frame. Ops are the effects alive. The legacy variant arms one
+		// timer per tick and per expiry in the timer heap instead.
+		typedef TStatusEffectTable<65536, 16384> FBenchEffectTable;
+		std::unique_ptr<FBenchEffectTable> Effects(new FBenchEffectTable());
+		struct FBenchEffectHandler
+		{
+			float Damage = 0.f;
+			int32 SpeedChanges = 0;
+			void OnEffectTick(int32, EStatusEffect, float Magnitude, uint32) { Damage += Magnitude; }
+			void OnSpeedChanged(int32) { SpeedChanges++; }
+		};
+		FBenchEffectHandler EffectHandler;
+		constexpr int32 EffectTicksPerSecond = 20;
+		int32 EffectTarget = 0;
+		uint32 EffectSource = 0;
+		const int32 TargetsPerFrame = (Characters + EffectTicksPerSecond - 1) / EffectTicksPerSecond;
+		OutResults.push_back(Measure("status_effects", Characters, [&](uint64& Ops, uint64&)
+		{
+			for (int32 Count = 0; Count < TargetsPerFrame; Count++)
+			{
+				const uint32 Duration = 20 + (EffectSource * 7u) % 41u;
+				Effects->Apply(EffectTarget, { EStatusEffect::DamageOverTime, 1.f, Duration, 5 }, EffectSource);
+				Effects->Apply(EffectTarget, { EStatusEffect::MoveSpeed, 0.7f, Duration, 0 }, EffectSource);
+				EffectSource++;
+				EffectTarget = (EffectTarget + 1) % Characters;
+			}
+			Effects->Advance(Effects->GetCurrentTick() + 1, EffectHandler);
+			GSink = EffectHandler.Damage + (float)EffectHandler.SpeedChanges;
+			Ops += (uint64)Effects->Num();
+		}));
+
+		FTimerHeap EffectTimers;
+		uint32 LegacyTick = 0;
+		uint32 LegacySource = 0;
+		int32 LegacyTarget = 0;
+		int32 LegacyAlive = 0;
+		OutResults.push_back(Measure("status_effects_legacy_timers", Characters, [&](uint64& Ops, uint64& Timers)
+		{
+			const uint64 RegisteredBefore = EffectTimers.Registered;
+			for (int32 Count = 0; Count < TargetsPerFrame; Count++)
+			{
+				const uint32 Duration = 20 + (LegacySource * 7u) % 41u;
+				// Kinds 1 and 2 expire the damage and the slow, the periodic damage timer carries its ticks left in its kind
+				EffectTimers.SetTimer(LegacyTick + 5.0, LegacyTarget, (int32)(Duration << 2));
+				EffectTimers.SetTimer(LegacyTick + (double)Duration, LegacyTarget, 1);
+				EffectTimers.SetTimer(LegacyTick + (double)Duration, LegacyTarget, 2);
+				LegacyAlive += 2;
+				LegacySource++;
+				LegacyTarget = (LegacyTarget + 1) % Characters;
+			}
+			LegacyTick++;
+			float Damage = 0.f;
+			while (!EffectTimers.Timers.empty() && EffectTimers.Timers.top().DueTime <= (double)LegacyTick)
+			{
+				const FTimerHeap::FTimer Timer = EffectTimers.Timers.top();
+				EffectTimers.Timers.pop();
+				if (Timer.Kind == 1 || Timer.Kind == 2)
+				{
+					LegacyAlive--;
+					continue;
+				}
+				Damage += 1.f;
+				const int32 TicksLeft = (Timer.Kind >> 2) - 5;
+				if (TicksLeft >= 5)
+				{
+					EffectTimers.SetTimer(Timer.DueTime + 5.0, Timer.Owner, TicksLeft << 2);
+				}
+			}
+			GSink = Damage;
+			Ops += (uint64)LegacyAlive;
+			Timers += EffectTimers.Registered - RegisteredBefore;
+		}));
+	}
+}
+
+int main(int ArgC, char** ArgV)
+{
+	const char* OutPath = nullptr;
+	for (int ArgIndex = 1; ArgIndex < ArgC; ArgIndex++)
+	{
+		if (std::strncmp(ArgV[ArgIndex], "--out=", 6) == 0)
+		{
+			OutPath = ArgV[ArgIndex] + 6;
+		}
+		else
+		{
+			std::fprintf(stderr, "Usage: CombatBench [--out=results.json]\n");
+			return 1;
+		}
+	}
+
+	std::vector<FBenchResult> Results;
+	for (const int32 Characters : { 1, 100, 10000 })
+	{
+		RunAll(Characters, Results);
+	}
+
+	FILE* Out = OutPath ? std::fopen(OutPath, "w") : stdout;
+	if (!Out)
+	{
+		std::fprintf(stderr, "Cannot write %s\n", OutPath);
+		return 1;
+	}
+	for (const FBenchResult& Result : Results)
+	{
+		std::fprintf(Out, "{\"benchmark\":\"%s\",\"characters\":%d,\"ops\":%llu,\"ns_per_op\":%.3f,\"timers_registered\":%llu,\"allocations\":%llu}\n",
+			Result.Name.c_str(), Result.Characters, (unsigned long long)Result.Ops, Result.NanosecondsPerOp,
+			(unsigned long long)Result.TimersRegistered, (unsigned long long)Result.Allocations);
+	}
+	if (Out != stdout)
+	{
+		std::fclose(Out);
+	}
+	return 0;
+}
+
+#endif
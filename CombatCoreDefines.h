@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * The combat core (cooldowns, regeneration, skills, rules and the simulator) only uses plain C++ so it can be
+ * built outside the engine for the headless combat simulator. Inside the engine it uses the Core types;
+ * outside it gets the few it needs from here.
+ */
+#if defined(WITH_ENGINE)
+
+#include "CoreMinimal.h"
+
+#else
+
+#include <cassert>
+#include <cstdint>
+
+typedef std::uint8_t uint8;
+typedef std::uint16_t uint16;
+typedef std::uint32_t uint32;
+typedef std::uint64_t uint64;
+typedef std::int16_t int16;
+typedef std::int32_t int32;
+typedef std::int64_t int64;
+
+#ifndef FORCEINLINE
+#define FORCEINLINE inline __attribute__((always_inline))
+#endif
+#ifndef check
+#define check(Expression) assert(Expression)
+#endif
+#ifndef INDEX_NONE
+#define INDEX_NONE (-1)
+#endif
+#ifndef RESTRICT
+#define RESTRICT __restrict
+#endif
+
+#endif
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatDamageSubsystem.h"
+#include "BossFightStats.h"
+#include "FighterAttributes.h"
+
+int32 UCombatDamageSubsystem::RegisterTarget(AActor* Owner, FFighterAttributes* Attributes, FSimpleDelegate OnDeath, FOnAttributesChanged OnChanged)
+{
+	check(Owner && Attributes);
+	int32 TargetIndex;
+	if (FreeIndices.Num() > 0)
+	{
+		TargetIndex = FreeIndices.Pop(false);
+	}
+	else
+	{
+		TargetIndex = Owners.AddUninitialized();
+		Health.AddUninitialized();
+		PendingDamage.AddUninitialized();
+		AttributeBlocks.AddUninitialized();
+		DeathCallbacks.AddDefaulted();
+		ChangeCallbacks.AddDefaulted();
+	}
+
+	Owners[TargetIndex] = Owner;
+	Health[TargetIndex] = Attributes->GetHealth();
+	PendingDamage[TargetIndex] = 0.f;
+	AttributeBlocks[TargetIndex] = Attributes;
+	DeathCallbacks[TargetIndex] = MoveTemp(OnDeath);
+	ChangeCallbacks[TargetIndex] = MoveTemp(OnChanged);
+	return TargetIndex;
+}
+
+void UCombatDamageSubsystem::UnregisterTarget(int32 TargetIndex)
+{
+	if (!Owners.IsValidIndex(TargetIndex) || !Owners[TargetIndex])
+	{
+		return;
+	}
+
+	// Keep the order of the other hits, the resolve sums them in queue order
+	Hits.RemoveAll([TargetIndex](const FDamageHit& Hit) { return Hit.Target == TargetIndex; });
+
+	Owners[TargetIndex] = nullptr;
+	// A free slot holds no health, so it never resolves a death
+	Health[TargetIndex] = 0.f;
+	PendingDamage[TargetIndex] = 0.f;
+	AttributeBlocks[TargetIndex] = nullptr;
+	DeathCallbacks[TargetIndex].Unbind();
+	ChangeCallbacks[TargetIndex].Unbind();
+	FreeIndices.Add(TargetIndex);
+}
+
+void UCombatDamageSubsystem::QueueDamage(int32 TargetIndex, float Amount, uint32 Source)
+{
+	if (Owners.IsValidIndex(TargetIndex) && Owners[TargetIndex])
+	{
+		Hits.Add({ TargetIndex, Amount, Source });
+	}
+}
+
+void UCombatDamageSubsystem::SetHealth(int32 TargetIndex, float NewHealth)
+{
+	if (Owners.IsValidIndex(TargetIndex) && Owners[TargetIndex])
+	{
+		Health[TargetIndex] = NewHealth;
+		AttributeBlocks[TargetIndex]->SetHealth(NewHealth);
+	}
+}
+
+float UCombatDamageSubsystem::GetHealth(int32 TargetIndex) const
+{
+	return Health.IsValidIndex(TargetIndex) ? Health[TargetIndex] : 0.f;
+}
+
+void UCombatDamageSubsystem::Heal(int32 TargetIndex, float Amount)
+{
+	// The dead stay dead until they rejoin
+	if (Owners.IsValidIndex(TargetIndex) && Owners[TargetIndex] && Health[TargetIndex] > 0.f)
+	{
+		SetHealth(TargetIndex, FMath::Min(Health[TargetIndex] + Amount, AttributeBlocks[TargetIndex]->GetMaxHealth()));
+	}
+}
+
+void UCombatDamageSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UCombatDamageSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	int32 NumDeaths = 0;
+	if (Hits.Num() > 0)
+	{
+		const int32 NumTargets = Owners.Num();
+		Died.SetNumUninitialized(NumTargets, false);
+		Deaths.SetNumUninitialized(NumTargets, false);
+
+		FDamageResolver::Accumulate(Hits.GetData(), Hits.Num(), PendingDamage.GetData());
+		FDamageResolver::Apply(Health.GetData(), PendingDamage.GetData(), Died.GetData(), NumTargets);
+		NumDeaths = FDamageResolver::GatherDeaths(Died.GetData(), NumTargets, Deaths.GetData());
+
+		for (const FDamageHit& Hit : Hits)
+		{
+			AttributeBlocks[Hit.Target]->SetHealth(Health[Hit.Target]);
+		}
+		Hits.Reset();
+	}
+
+	// Every change of the frame, damage or not, goes out in one pass; callbacks are copied first, like the deaths
+	DueChanges.Reset();
+	for (int32 TargetIndex = 0; TargetIndex < Owners.Num(); TargetIndex++)
+	{
+		if (Owners[TargetIndex] && AttributeBlocks[TargetIndex]->GetDirtyMask() != 0)
+		{
+			DueChanges.Emplace(ChangeCallbacks[TargetIndex], AttributeBlocks[TargetIndex]->TakeDirtyMask());
+		}
+	}
+	FBossFightStats::SetAttributeChanges(DueChanges.Num());
+	for (const TPair<FOnAttributesChanged, uint32>& DueChange : DueChanges)
+	{
+		DueChange.Key.ExecuteIfBound(DueChange.Value);
+	}
+
+	// A death may unregister targets or queue new hits
+	DueDeathCallbacks.Reset();
+	for (int32 DeathIndex = 0; DeathIndex < NumDeaths; DeathIndex++)
+	{
+		DueDeathCallbacks.Add(DeathCallbacks[Deaths[DeathIndex]]);
+	}
+	for (const FSimpleDelegate& DeathCallback : DueDeathCallbacks)
+	{
+		DeathCallback.ExecuteIfBound();
+	}
+}
+
+TStatId UCombatDamageSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_DamageTick);
+}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DamageResolver.h"
+#include "CombatDamageSubsystem.generated.h"
+
+struct FFighterAttributes;
+
+/** Called with the EFighterAttribute bits that changed */
+DECLARE_DELEGATE_OneParam(FOnAttributesChanged, uint32);
+
+/**
+ * Owns the health of every fighter of the world, applies damage and publishes attribute changes once per frame.
+ * Hits are only queued when skills land; Tick sums them per target, updates all health values in one pass and
+ * copies the new values to the attribute blocks of the actors. It then takes the dirty mask of every block and
+ * hands the changes to their owners, and runs the death callbacks last.
+ * Target indices stay valid until the target unregisters, freed indices are reused.
+ */
+UCLASS()
+class BOSSFIGHT_API UCombatDamageSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Adds a damage target and returns its index.
+	 * @param Attributes	Attribute block of the owner, its health is kept equal to the health stored here
+	 * @param OnDeath		Called once when the health of the target drops to zero or below
+	 * @param OnChanged		Called once per frame at most, with the attributes of the block that changed
+	 */
+	int32 RegisterTarget(AActor* Owner, FFighterAttributes* Attributes, FSimpleDelegate OnDeath, FOnAttributesChanged OnChanged);
+	/** Frees a target index, hits still queued against it are dropped */
+	void UnregisterTarget(int32 TargetIndex);
+
+	/** Queues a hit, it is applied on the next resolve */
+	void QueueDamage(int32 TargetIndex, float Amount, uint32 Source);
+
+	/** Sets the health of a target right away, for potions and scripted changes */
+	void SetHealth(int32 TargetIndex, float NewHealth);
+	float GetHealth(int32 TargetIndex) const;
+	/** Raises the health of a living target by Amount, up to its max health */
+	void Heal(int32 TargetIndex, float Amount);
+	/** Actor registered at an index, nullptr for free indices */
+	FORCEINLINE AActor* GetOwner(int32 TargetIndex) const { return Owners.IsValidIndex(TargetIndex) ? Owners[TargetIndex] : nullptr; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Per target state, indexed by target index */
+	UPROPERTY()
+	TArray<AActor*> Owners;
+	TArray<float> Health;
+	TArray<float> PendingDamage;
+	TArray<FFighterAttributes*> AttributeBlocks;
+	TArray<FSimpleDelegate> DeathCallbacks;
+	TArray<FOnAttributesChanged> ChangeCallbacks;
+	TArray<int32> FreeIndices;
+
+	/** Hits of the current frame in the order they landed */
+	TArray<FDamageHit> Hits;
+
+	/** Scratch arrays of the resolve, kept to avoid reallocating */
+	TArray<uint8> Died;
+	TArray<int32> Deaths;
+	TArray<FSimpleDelegate> DueDeathCallbacks;
+	TArray<TPair<FOnAttributesChanged, uint32>> DueChanges;
+};
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include <atomic>
+#include <cstring>
+
+/** The event log is compiled out of Shipping builds, COMBAT_LOG_EVENT then expands to nothing */
+#ifndef COMBAT_EVENT_LOG_ENABLED
+	#if defined(WITH_ENGINE)
+		#define COMBAT_EVENT_LOG_ENABLED (!UE_BUILD_SHIPPING)
+	#else
+		#define COMBAT_EVENT_LOG_ENABLED 1
+	#endif
+#endif
+
+enum class ECombatEventType : uint8
+{
+	/** Values: skill id, damage */
+	SkillCast,
+	/** Values: potion kind (0 health, 1 ability point), charges left */
+	Potion,
+	/** Values: none */
+	OverlapBegin,
+	OverlapEnd,
+	/** Values: distance to the pawn */
+	SawPawn,
+	/** Values: distance to the noise, loudness */
+	HeardNoise,
+	/** Values: target X, target Y */
+	Roam,
+	/** Values: ability points */
+	AbilityPointFull,
+	/** Values: health */
+	Death,
+
+	Count
+};
+
+/** One entry of the combat event log, plain data so it can be copied and written to disk as is */
+struct FCombatEvent
+{
+	/** World time in seconds */
+	double Time;
+	/** Unique id of the actor the event happened to */
+	uint32 ActorId;
+	ECombatEventType Type;
+	uint8 Padding[3];
+	float Values[2];
+};
+
+static_assert(sizeof(FCombatEvent) == 24, "FCombatEvent is written to disk as is");
+
+/**
+ * Fixed-size multi-producer ring of combat events. Logging is a fetch_add and a few stores, it never blocks and
+ * never allocates; when the ring is full the oldest events are overwritten.
+ * Every slot carries a sequence number written around the event so readers on any thread can tell complete events
+ * from overwritten or half-written ones without taking a lock.
+ */
+template<uint32 CapacityPow2>
+class TCombatEventRing
+{
+	static_assert(CapacityPow2 > 0 && (CapacityPow2 & (CapacityPow2 - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	static constexpr uint32 Capacity = CapacityPow2;
+
+	FORCEINLINE void Log(double Time, uint32 ActorId, ECombatEventType Type, float Value0 = 0.f, float Value1 = 0.f)
+	{
+		const uint64 Ticket = Head.fetch_add(1, std::memory_order_relaxed);
+		FSlot& Slot = Slots[Ticket & (Capacity - 1)];
+
+		// Odd while writing, 2 * (Ticket + 1) once the event is complete
+		Slot.Sequence.store(2 * Ticket + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Slot.Event.Time = Time;
+		Slot.Event.ActorId = ActorId;
+		Slot.Event.Type = Type;
+		Slot.Event.Values[0] = Value0;
+		Slot.Event.Values[1] = Value1;
+		Slot.Sequence.store(2 * Ticket + 2, std::memory_order_release);
+	}
+
+	/** Number of events logged so far, the ticket of the next event */
+	FORCEINLINE uint64 GetHead() const
+	{
+		return Head.load(std::memory_order_acquire);
+	}
+
+	/** Oldest ticket that may still be in the ring */
+	FORCEINLINE uint64 GetTail() const
+	{
+		const uint64 CurrentHead = GetHead();
+		return CurrentHead > Capacity ? CurrentHead - Capacity : 0;
+	}
+
+	/** Copies the event of a ticket, false if it is not complete yet or was overwritten */
+	bool Read(uint64 Ticket, FCombatEvent& OutEvent) const
+	{
+		const FSlot& Slot = Slots[Ticket & (Capacity - 1)];
+		const uint64 Expected = 2 * Ticket + 2;
+		if (Slot.Sequence.load(std::memory_order_acquire) != Expected)
+		{
+			return false;
+		}
+		std::memcpy(&OutEvent, (const void*)&Slot.Event, sizeof(FCombatEvent));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return Slot.Sequence.load(std::memory_order_relaxed) == Expected;
+	}
+
+	/** Copies up to MaxEvents of the most recent complete events, oldest first. Returns the number copied. */
+	int32 CopyRecent(FCombatEvent* OutEvents, int32 MaxEvents) const
+	{
+		const uint64 CurrentHead = GetHead();
+		const uint64 Wanted = MaxEvents < (int32)Capacity ? (uint64)MaxEvents : Capacity;
+		uint64 Ticket = CurrentHead > Wanted ? CurrentHead - Wanted : 0;
+		int32 NumCopied = 0;
+		for (; Ticket < CurrentHead; Ticket++)
+		{
+			if (Read(Ticket, OutEvents[NumCopied]))
+			{
+				NumCopied++;
+			}
+		}
+		return NumCopied;
+	}
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint64> Sequence{ 0 };
+		FCombatEvent Event{};
+	};
+
+	/** Kept on its own cache line so producers do not false-share with the first slots */
+	alignas(64) std::atomic<uint64> Head{ 0 };
+	alignas(64) FSlot Slots[Capacity];
+};
+
+/** Size of the log of the game, about 128 KB */
+typedef TCombatEventRing<4096> FCombatEventRing;
+
+#if COMBAT_EVENT_LOG_ENABLED
+
+/** The combat event log of the process, constant-initialized so logging needs no guard */
+inline FCombatEventRing GCombatEventLog;
+
+FORCEINLINE FCombatEventRing& GetCombatEventLog()
+{
+	return GCombatEventLog;
+}
+
+#define COMBAT_LOG_EVENT(Time, ActorId, Type, ...) GetCombatEventLog().Log((Time), (ActorId), (Type), ##__VA_ARGS__)
+
+#else
+
+#define COMBAT_LOG_EVENT(Time, ActorId, Type, ...)
+
+#endif
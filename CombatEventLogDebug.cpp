@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatEventLogDebug.h"
+
+#if COMBAT_EVENT_LOG_ENABLED
+
+#include "Async/Async.h"
+#include "Debug/DebugDrawService.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+	/** Events shown by the overlay */
+	constexpr int32 OverlayEvents = 24;
+
+	const TCHAR* const GCombatEventNames[] = { TEXT("SkillCast"), TEXT("Potion"), TEXT("OverlapBegin"), TEXT("OverlapEnd"),
+		TEXT("SawPawn"), TEXT("HeardNoise"), TEXT("Roam"), TEXT("AbilityPointFull"), TEXT("Death") };
+	static_assert(UE_ARRAY_COUNT(GCombatEventNames) == (int32)ECombatEventType::Count, "Missing combat event name");
+
+	int32 GCombatEventOverlay = 0;
+	FAutoConsoleVariableRef CVarCombatEventOverlay(
+		TEXT("BossFight.CombatEventOverlay"),
+		GCombatEventOverlay,
+		TEXT("Draws the latest combat events on screen.\n0: off, 1: on"));
+
+	FAutoConsoleCommand FlushCombatEventsCommand(
+		TEXT("BossFight.FlushCombatEvents"),
+		TEXT("Appends the combat events logged since the last flush to a binary file, Saved/CombatEvents.bin by default"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			FCombatEventLogDebug::FlushToFile(Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("CombatEvents.bin"));
+		}));
+
+	FDelegateHandle GOverlayHandle;
+	/** First ticket not written to disk yet */
+	std::atomic<uint64> GFlushedTicket(0);
+	std::atomic<bool> GFlushInFlight(false);
+
+	void DrawOverlay(UCanvas* Canvas, APlayerController* PlayerController)
+	{
+		if (!GCombatEventOverlay || !Canvas)
+		{
+			return;
+		}
+
+		FCombatEvent Events[OverlayEvents];
+		const int32 NumEvents = GetCombatEventLog().CopyRecent(Events, OverlayEvents);
+		UFont* Font = GEngine->GetSmallFont();
+		float Y = Canvas->ClipY * 0.2f;
+		for (int32 EventIndex = NumEvents - 1; EventIndex >= 0; EventIndex--)
+		{
+			const FCombatEvent& Event = Events[EventIndex];
+			Canvas->SetDrawColor(EventIndex == NumEvents - 1 ? FColor::Yellow : FColor::White);
+			Canvas->DrawText(Font, FString::Printf(TEXT("%9.3f  %8u  %-16s %10.2f %10.2f"), Event.Time, Event.ActorId,
+				GCombatEventNames[(int32)Event.Type], Event.Values[0], Event.Values[1]), 10.f, Y);
+			Y += 12.f;
+		}
+	}
+}
+
+void FCombatEventLogDebug::Register()
+{
+	GOverlayHandle = UDebugDrawService::Register(TEXT("Game"), FDebugDrawDelegate::CreateStatic(&DrawOverlay));
+}
+
+void FCombatEventLogDebug::Unregister()
+{
+	UDebugDrawService::Unregister(GOverlayHandle);
+	GOverlayHandle.Reset();
+}
+
+void FCombatEventLogDebug::FlushToFile(const FString& Filename)
+{
+	if (GFlushInFlight.exchange(true))
+	{
+		return;
+	}
+
+	Async(EAsyncExecution::ThreadPool, [Filename]()
+	{
+		const FCombatEventRing& Log = GetCombatEventLog();
+		const uint64 Head = Log.GetHead();
+		const uint64 Tail = Log.GetTail();
+		uint64 Ticket = FMath::Max(GFlushedTicket.load(), Tail);
+
+		if (Ticket < Head)
+		{
+			TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename, FILEWRITE_Append | FILEWRITE_AllowRead));
+			if (Writer)
+			{
+				FCombatEvent Event;
+				for (; Ticket < Head; Ticket++)
+				{
+					if (Log.Read(Ticket, Event))
+					{
+						Writer->Serialize(&Event, sizeof(Event));
+					}
+				}
+				Writer->Close();
+			}
+		}
+
+		GFlushedTicket.store(Head);
+		GFlushInFlight.store(false);
+	});
+}
+
+#endif
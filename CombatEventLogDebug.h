@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatEventLog.h"
+
+#if COMBAT_EVENT_LOG_ENABLED
+
+/**
+ * Engine side of the combat event log: an on-screen overlay of the latest events (BossFight.CombatEventOverlay 1)
+ * and BossFight.FlushCombatEvents [File], which appends the events logged since the last flush to a binary file
+ * of raw FCombatEvent records from a background thread.
+ */
+struct FCombatEventLogDebug
+{
+	static void Register();
+	static void Unregister();
+
+	/** Appends the new events to Filename on the thread pool, does nothing while a flush is running */
+	static void FlushToFile(const FString& Filename);
+};
+
+#endif
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatReplication.h"
+
+bool FRepRegeneratingAttribute::Update(const FRegeneratingAttribute& Attribute)
+{
+	const float MaxValue = Attribute.GetMaxValue();
+	const float Fraction = MaxValue > 0.f ? FMath::Clamp(Attribute.GetBaseValue() / MaxValue, 0.f, 1.f) : 0.f;
+	FRepRegeneratingAttribute NewValue;
+	NewValue.QuantizedValue = (uint8)FMath::RoundToInt(Fraction * MAX_uint8);
+	NewValue.BaseTime = (float)Attribute.GetBaseTime();
+	if (NewValue == *this)
+	{
+		return false;
+	}
+	*this = NewValue;
+	return true;
+}
+
+FRegeneratingAttribute FRepRegeneratingAttribute::ToAttribute(float MaxValue, float RegenRate) const
+{
+	return FRegeneratingAttribute(MaxValue * ((float)QuantizedValue / MAX_uint8), MaxValue, RegenRate, BaseTime);
+}
+
+bool FRepRegeneratingAttribute::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << QuantizedValue;
+	Ar << BaseTime;
+	bOutSuccess = true;
+	return true;
+}
+
+bool FRepCooldowns::Update(const FCooldownTracker& Cooldowns)
+{
+	bool bChanged = false;
+	for (int32 Slot = 0; Slot < FCooldownTracker::MaxSlots; Slot++)
+	{
+		const float ExpiryTime = (float)Cooldowns.GetExpiryTime(Slot);
+		bChanged |= ExpiryTime != ExpiryTimes[Slot];
+		ExpiryTimes[Slot] = ExpiryTime;
+	}
+	return bChanged;
+}
+
+void FRepCooldowns::ApplyTo(FCooldownTracker& Cooldowns) const
+{
+	for (int32 Slot = 0; Slot < FCooldownTracker::MaxSlots; Slot++)
+	{
+		Cooldowns.SetExpiryTime(Slot, ExpiryTimes[Slot]);
+	}
+}
+
+bool FRepCooldowns::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	static_assert(FCooldownTracker::MaxSlots <= 16, "The slot mask is 16 bits");
+
+	uint16 StartedSlots = 0;
+	if (Ar.IsSaving())
+	{
+		for (int32 Slot = 0; Slot < FCooldownTracker::MaxSlots; Slot++)
+		{
+			StartedSlots |= ExpiryTimes[Slot] != 0.f ? (uint16)(1 << Slot) : 0;
+		}
+	}
+	Ar << StartedSlots;
+
+	for (int32 Slot = 0; Slot < FCooldownTracker::MaxSlots; Slot++)
+	{
+		if (StartedSlots & (1 << Slot))
+		{
+			Ar << ExpiryTimes[Slot];
+		}
+		else if (Ar.IsLoading())
+		{
+			ExpiryTimes[Slot] = 0.f;
+		}
+	}
+
+	bOutSuccess = true;
+	return true;
+}
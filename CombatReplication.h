@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CooldownTracker.h"
+#include "RegeneratingAttribute.h"
+#include "CombatReplication.generated.h"
+
+/**
+ * Quantized network forms of the combat attributes. All of them are only sent when they change: health is 16 bits
+ * of the maximum health, a regenerating attribute is its 8-bit base value and the server time it was set at, and
+ * cooldowns are the server times they expire at, so neither regeneration nor a running cooldown costs bandwidth.
+ */
+struct FCombatQuantization
+{
+	static uint16 QuantizeHealth(float Health, float MaxHealth)
+	{
+		const float Fraction = MaxHealth > 0.f ? FMath::Clamp(Health / MaxHealth, 0.f, 1.f) : 0.f;
+		return (uint16)FMath::RoundToInt(Fraction * MAX_uint16);
+	}
+
+	static float DequantizeHealth(uint16 QuantizedHealth, float MaxHealth)
+	{
+		return MaxHealth * ((float)QuantizedHealth / MAX_uint16);
+	}
+
+	/** Quantizes Health and returns true if that changed RepHealth */
+	static bool UpdateHealth(uint16& RepHealth, float Health, float MaxHealth)
+	{
+		const uint16 NewRepHealth = QuantizeHealth(Health, MaxHealth);
+		if (NewRepHealth == RepHealth)
+		{
+			return false;
+		}
+		RepHealth = NewRepHealth;
+		return true;
+	}
+};
+
+USTRUCT()
+struct FRepRegeneratingAttribute
+{
+	GENERATED_BODY()
+
+	/** Base value in 1/255 of the cap */
+	uint8 QuantizedValue = 0;
+	/** Server time of the base value */
+	float BaseTime = 0.f;
+
+	/** Copies the state of Attribute and returns true if the replicated form changed */
+	bool Update(const FRegeneratingAttribute& Attribute);
+	FRegeneratingAttribute ToAttribute(float MaxValue, float RegenRate) const;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FRepRegeneratingAttribute& Other) const
+	{
+		return QuantizedValue == Other.QuantizedValue && BaseTime == Other.BaseTime;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FRepRegeneratingAttribute> : public TStructOpsTypeTraitsBase2<FRepRegeneratingAttribute>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
+
+USTRUCT()
+struct FRepCooldowns
+{
+	GENERATED_BODY()
+
+	/** Server time each slot expires at, 0 for slots never started */
+	float ExpiryTimes[FCooldownTracker::MaxSlots] = {};
+
+	/** Copies the expiry times of Cooldowns and returns true if the replicated form changed */
+	bool Update(const FCooldownTracker& Cooldowns);
+	void ApplyTo(FCooldownTracker& Cooldowns) const;
+
+	/** Writes a mask of the started slots followed by their expiry times */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FRepCooldowns& Other) const
+	{
+		return FMemory::Memcmp(ExpiryTimes, Other.ExpiryTimes, sizeof(ExpiryTimes)) == 0;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FRepCooldowns> : public TStructOpsTypeTraitsBase2<FRepCooldowns>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
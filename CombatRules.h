@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "CooldownTracker.h"
+#include "RegeneratingAttribute.h"
+
+/** Base attributes of the fighters */
+struct FFighterDefaults
+{
+	static constexpr float PlayerMaxHealth = 200.f;
+	static constexpr float BossMaxHealth = 500.f;
+	static constexpr float MaxAbilityPoint = 100.f;
+	/** One point every 0.3 seconds */
+	static constexpr float AbilityPointRegenRate = 1.f / 0.3f;
+	static constexpr float PotionCharges = 5.f;
+	/** Seconds a predicted skill may arrive early on the server, covers jitter between client and server clocks */
+	static constexpr float SkillPredictionTolerance = 0.1f;
+};
+
+/** How a potion refills a value */
+struct FPotionRules
+{
+	float Amount;
+	/** Cooldown in seconds */
+	float Cooldown;
+	uint8 CooldownSlot;
+};
+
+constexpr FPotionRules GHealthPotionRules = { 50.f, 10.f, (uint8)ECooldownSlot::HealthPotion };
+constexpr FPotionRules GAbilityPointPotionRules = { 30.f, 10.f, (uint8)ECooldownSlot::AbilityPointPotion };
+
+/** Combat rules shared by the actors and the headless simulator */
+struct FCombatRules
+{
+	/**
+	 * Drinks a health potion if the fighter is hurt, off cooldown and has a charge left.
+	 * Refills Amount, or up to MaxHealth when missing less than that. Returns true if a charge was used.
+	 */
+	static bool UseHealthPotion(float& Health, float MaxHealth, float& Charges, FCooldownTracker& Cooldowns, const FPotionRules& Rules, double Now)
+	{
+		if (Health >= MaxHealth || !Cooldowns.IsReady(Rules.CooldownSlot, Now) || Charges <= 0.f)
+		{
+			return false;
+		}
+		if (Health >= MaxHealth - Rules.Amount)
+		{
+			Health = MaxHealth;
+		}
+		else if (Health > 0.f)
+		{
+			Health += Rules.Amount;
+		}
+		Cooldowns.Start(Rules.CooldownSlot, Now, Rules.Cooldown);
+		Charges -= 1.f;
+		return true;
+	}
+
+	/** Same as UseHealthPotion for ability points */
+	static bool UseAbilityPointPotion(FRegeneratingAttribute& AbilityPoint, float& Charges, FCooldownTracker& Cooldowns, const FPotionRules& Rules, double Now)
+	{
+		const float Current = AbilityPoint.Get(Now);
+		const float MaxValue = AbilityPoint.GetMaxValue();
+		if (Current >= MaxValue || !Cooldowns.IsReady(Rules.CooldownSlot, Now) || Charges <= 0.f)
+		{
+			return false;
+		}
+		if (Current >= MaxValue - Rules.Amount)
+		{
+			AbilityPoint.Set(MaxValue, Now);
+		}
+		else if (Current > 0.f)
+		{
+			AbilityPoint.Set(Current + Rules.Amount, Now);
+		}
+		Cooldowns.Start(Rules.CooldownSlot, Now, Rules.Cooldown);
+		Charges -= 1.f;
+		return true;
+	}
+};
+
+/**
+ * Small deterministic random stream (splitmix64 seeding, xorshift64* output).
+ * The same seed gives the same rolls on every platform, inside and outside the engine.
+ */
+struct FCombatRandom
+{
+	explicit FCombatRandom(uint64 Seed = 0)
+	{
+		Initialize(Seed);
+	}
+
+	void Initialize(uint64 Seed)
+	{
+		State = Mix(Seed);
+		if (State == 0)
+		{
+			State = 0x9E3779B97F4A7C15ull;
+		}
+	}
+
+	FORCEINLINE uint32 Next()
+	{
+		State ^= State >> 12;
+		State ^= State << 25;
+		State ^= State >> 27;
+		return (uint32)((State * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	/** Uniform integer in [Min, Max] */
+	FORCEINLINE int32 RandRange(int32 Min, int32 Max)
+	{
+		const uint64 Range = (uint64)(int64)(Max - Min) + 1;
+		return Min + (int32)(((uint64)Next() * Range) >> 32);
+	}
+
+	/** Uniform float in [0, 1) */
+	FORCEINLINE float FRand()
+	{
+		return (float)(Next() >> 8) * (1.f / 16777216.f);
+	}
+
+	/** Stream StreamIndex of a family of independent streams sharing Seed, how each boss gets its own */
+	static FORCEINLINE FCombatRandom ForStream(uint64 Seed, uint64 StreamIndex)
+	{
+		return FCombatRandom(Seed ^ Mix(StreamIndex));
+	}
+
+	/** splitmix64 finalizer, also handy to derive independent seeds from one */
+	static FORCEINLINE uint64 Mix(uint64 Value)
+	{
+		Value += 0x9E3779B97F4A7C15ull;
+		Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+		return Value ^ (Value >> 31);
+	}
+
+	uint64 State;
+};
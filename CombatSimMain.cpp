@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Headless combat simulator for balance sweeps, built outside the engine:
+//	g++ -std=c++17 -O2 -pthread CombatSimMain.cpp CombatSimulator.cpp FightReplay.cpp -o CombatSim
+//	./CombatSim --fights=10000000 --boss-health=450
+//	./CombatSim --replay=Saved/Fights/Arena_2024.01.01-12.00.00.bfr --repeat=1000
+// The engine build skips this file.
+
+#if !defined(WITH_ENGINE)
+
+#include "CombatSimulator.h"
+#include "FightReplay.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/** Time-to-kill histogram resolution in seconds */
+	constexpr double BucketSize = 0.5;
+
+	struct FSweepStats
+	{
+		uint64 Fights = 0;
+		uint64 PlayerWins = 0;
+		uint64 Timeouts = 0;
+		uint64 PlayerCasts = 0;
+		uint64 BossCasts = 0;
+		std::vector<uint64> PlayerWinTimes;
+		std::vector<uint64> BossWinTimes;
+
+		explicit FSweepStats(size_t NumBuckets)
+			: PlayerWinTimes(NumBuckets, 0)
+			, BossWinTimes(NumBuckets, 0)
+		{
+		}
+
+		void Merge(const FSweepStats& Other)
+		{
+			Fights += Other.Fights;
+			PlayerWins += Other.PlayerWins;
+			Timeouts += Other.Timeouts;
+			PlayerCasts += Other.PlayerCasts;
+			BossCasts += Other.BossCasts;
+			for (size_t Bucket = 0; Bucket < PlayerWinTimes.size(); Bucket++)
+			{
+				PlayerWinTimes[Bucket] += Other.PlayerWinTimes[Bucket];
+				BossWinTimes[Bucket] += Other.BossWinTimes[Bucket];
+			}
+		}
+	};
+
+	double Percentile(const std::vector<uint64>& Histogram, double Fraction)
+	{
+		uint64 Total = 0;
+		for (const uint64 Count : Histogram)
+		{
+			Total += Count;
+		}
+		if (Total == 0)
+		{
+			return 0.0;
+		}
+		const uint64 Rank = (uint64)(Fraction * (double)(Total - 1));
+		uint64 Seen = 0;
+		for (size_t Bucket = 0; Bucket < Histogram.size(); Bucket++)
+		{
+			Seen += Histogram[Bucket];
+			if (Seen > Rank)
+			{
+				return (double)(Bucket + 1) * BucketSize;
+			}
+		}
+		return (double)Histogram.size() * BucketSize;
+	}
+
+	void PrintDistribution(const char* Label, const std::vector<uint64>& Histogram)
+	{
+		std::printf("%s ttk p10=%.1fs p50=%.1fs p90=%.1fs p99=%.1fs\n", Label,
+			Percentile(Histogram, 0.10), Percentile(Histogram, 0.50), Percentile(Histogram, 0.90), Percentile(Histogram, 0.99));
+	}
+
+	bool ParseArgument(const char* Argument, const char* Name, double& OutValue)
+	{
+		const size_t NameLength = std::strlen(Name);
+		if (std::strncmp(Argument, Name, NameLength) == 0 && Argument[NameLength] == '=')
+		{
+			OutValue = std::atof(Argument + NameLength + 1);
+			return true;
+		}
+		return false;
+	}
+
+	bool ParseArgument(const char* Argument, const char* Name, std::string& OutValue)
+	{
+		const size_t NameLength = std::strlen(Name);
+		if (std::strncmp(Argument, Name, NameLength) == 0 && Argument[NameLength] == '=')
+		{
+			OutValue = Argument + NameLength + 1;
+			return true;
+		}
+		return false;
+	}
+
+	bool LoadFile(const std::string& Path, std::vector<uint8>& OutData)
+	{
+		FILE* File = std::fopen(Path.c_str(), "rb");
+		if (!File)
+		{
+			return false;
+		}
+		uint8 Chunk[64 * 1024];
+		size_t Read = 0;
+		while ((Read = std::fread(Chunk, 1, sizeof(Chunk), File)) > 0)
+		{
+			OutData.insert(OutData.end(), Chunk, Chunk + Read);
+		}
+		std::fclose(File);
+		return true;
+	}
+
+	/** Replays a recording Repeat times and prints how much faster than the game it ran, fails on a diverging replay */
+	int RunReplay(const FCombatSimConfig& Config, const FSkillTable& PlayerSkills, const FSkillTable& BossSkills, const std::string& Path, uint64 Repeat)
+	{
+		std::vector<uint8> Data;
+		if (!LoadFile(Path, Data))
+		{
+			std::fprintf(stderr, "Cannot read %s\n", Path.c_str());
+			return 1;
+		}
+
+		const FFightReplay Replay(Config, PlayerSkills, BossSkills);
+		FReplayResult Result;
+		const auto StartTime = std::chrono::steady_clock::now();
+		for (uint64 Iteration = 0; Iteration < Repeat; Iteration++)
+		{
+			if (!Replay.Run(Data.data(), (int64)Data.size(), Result))
+			{
+				std::fprintf(stderr, "%s is not a fight recording\n", Path.c_str());
+				return 1;
+			}
+		}
+		const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+		std::printf("records=%d bytes=%zu fight_seconds=%.1f\n", Result.Records, Data.size(), Result.Duration);
+		std::printf("replays=%llu seconds=%.3f speedup=%.0fx\n",
+			(unsigned long long)Repeat, Seconds, Seconds > 0.0 ? Result.Duration * Repeat / Seconds : 0.0);
+		std::printf("player_casts=%d boss_casts=%d rejected=%d deaths=%d death_mismatches=%d\n",
+			Result.PlayerCasts, Result.BossCasts, Result.RejectedActions, Result.Deaths, Result.DeathMismatches);
+		return Result.DeathMismatches == 0 ? 0 : 2;
+	}
+}
+
+int main(int ArgC, char** ArgV)
+{
+	FCombatSimConfig Config;
+	double Fights = 1000000;
+	double Threads = std::thread::hardware_concurrency();
+	double Seed = 1;
+	double Repeat = 1;
+	std::string ReplayPath;
+
+	for (int ArgIndex = 1; ArgIndex < ArgC; ArgIndex++)
+	{
+		const char* Argument = ArgV[ArgIndex];
+		double Value = 0.0;
+		if (ParseArgument(Argument, "--fights", Fights) || ParseArgument(Argument, "--threads", Threads) || ParseArgument(Argument, "--seed", Seed)
+			|| ParseArgument(Argument, "--replay", ReplayPath) || ParseArgument(Argument, "--repeat", Repeat))
+		{
+			continue;
+		}
+		if (ParseArgument(Argument, "--player-health", Value)) { Config.PlayerMaxHealth = (float)Value; continue; }
+		if (ParseArgument(Argument, "--boss-health", Value)) { Config.BossMaxHealth = (float)Value; continue; }
+		if (ParseArgument(Argument, "--player-damage", Value)) { Config.PlayerDamageScale = (float)Value; continue; }
+		if (ParseArgument(Argument, "--boss-damage", Value)) { Config.BossDamageScale = (float)Value; continue; }
+		if (ParseArgument(Argument, "--reengage", Value)) { Config.BossReengageDelay = (float)Value; continue; }
+		if (ParseArgument(Argument, "--step", Value)) { Config.TimeStep = (float)Value; continue; }
+		if (ParseArgument(Argument, "--max-time", Value)) { Config.MaxFightTime = (float)Value; continue; }
+		std::fprintf(stderr,
+			"Unknown argument %s\n"
+			"Usage: CombatSim [--fights=N] [--threads=N] [--seed=N] [--player-health=X] [--boss-health=X]\n"
+			"                 [--player-damage=X] [--boss-damage=X] [--reengage=S] [--step=S] [--max-time=S]\n"
+			"       CombatSim --replay=FILE [--repeat=N] [--player-damage=X] [--boss-damage=X]\n", Argument);
+		return 1;
+	}
+
+	FSkillTable PlayerSkills;
+	PlayerSkills.Assign(GPlayerDefaultSkills);
+	FSkillTable BossSkills;
+	BossSkills.Assign(GBossDefaultSkills);
+	if (!ReplayPath.empty())
+	{
+		return RunReplay(Config, PlayerSkills, BossSkills, ReplayPath, Repeat >= 1.0 ? (uint64)Repeat : 1);
+	}
+	const FCombatSimulator Simulator(Config, PlayerSkills, BossSkills);
+
+	const uint64 NumFights = (uint64)Fights;
+	const unsigned NumThreads = Threads >= 1.0 ? (unsigned)Threads : 1u;
+	const size_t NumBuckets = (size_t)(Config.MaxFightTime / BucketSize) + 2;
+	const uint64 BaseSeed = (uint64)Seed;
+
+	// Fights are handed out in chunks; each fight is seeded from its index so results do not depend on the thread count
+	constexpr uint64 ChunkSize = 4096;
+	std::atomic<uint64> NextFight(0);
+	std::vector<FSweepStats> ThreadStats(NumThreads, FSweepStats(NumBuckets));
+	std::vector<std::thread> Workers;
+
+	const auto StartTime = std::chrono::steady_clock::now();
+	for (unsigned ThreadIndex = 0; ThreadIndex < NumThreads; ThreadIndex++)
+	{
+		Workers.emplace_back([&, ThreadIndex]()
+		{
+			FSweepStats& Stats = ThreadStats[ThreadIndex];
+			for (;;)
+			{
+				const uint64 First = NextFight.fetch_add(ChunkSize);
+				if (First >= NumFights)
+				{
+					break;
+				}
+				const uint64 Last = First + ChunkSize < NumFights ? First + ChunkSize : NumFights;
+				for (uint64 FightIndex = First; FightIndex < Last; FightIndex++)
+				{
+					const FFightResult Result = Simulator.RunFight(FCombatRandom::Mix(BaseSeed ^ FCombatRandom::Mix(FightIndex)));
+					const size_t Bucket = (size_t)(Result.Duration / BucketSize);
+					Stats.Fights++;
+					Stats.PlayerCasts += Result.PlayerCasts;
+					Stats.BossCasts += Result.BossCasts;
+					if (Result.bTimedOut)
+					{
+						Stats.Timeouts++;
+					}
+					else if (Result.bPlayerWon)
+					{
+						Stats.PlayerWins++;
+						Stats.PlayerWinTimes[Bucket < NumBuckets ? Bucket : NumBuckets - 1]++;
+					}
+					else
+					{
+						Stats.BossWinTimes[Bucket < NumBuckets ? Bucket : NumBuckets - 1]++;
+					}
+				}
+			}
+		});
+	}
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+	const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	FSweepStats Total(NumBuckets);
+	for (const FSweepStats& Stats : ThreadStats)
+	{
+		Total.Merge(Stats);
+	}
+
+	const double FightCount = Total.Fights > 0 ? (double)Total.Fights : 1.0;
+	std::printf("fights=%llu threads=%u seconds=%.3f fights_per_second=%.0f\n",
+		(unsigned long long)Total.Fights, NumThreads, Seconds, Seconds > 0.0 ? Total.Fights / Seconds : 0.0);
+	std::printf("player_health=%.0f boss_health=%.0f player_damage=%.2f boss_damage=%.2f reengage=%.2f\n",
+		Config.PlayerMaxHealth, Config.BossMaxHealth, Config.PlayerDamageScale, Config.BossDamageScale, Config.BossReengageDelay);
+	std::printf("player_win_rate=%.4f boss_win_rate=%.4f timeout_rate=%.4f\n",
+		Total.PlayerWins / FightCount, (Total.Fights - Total.PlayerWins - Total.Timeouts) / FightCount, Total.Timeouts / FightCount);
+	std::printf("player_casts_per_fight=%.2f boss_casts_per_fight=%.2f\n", Total.PlayerCasts / FightCount, Total.BossCasts / FightCount);
+	PrintDistribution("player_win", Total.PlayerWinTimes);
+	PrintDistribution("boss_win", Total.BossWinTimes);
+	return 0;
+}
+
+#endif
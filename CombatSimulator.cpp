@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatSimulator.h"
+#include "SkillExecutor.h"
+#include <cmath>
+
+FCombatSimulator::FCombatSimulator(const FCombatSimConfig& InConfig, const FSkillTable& InPlayerSkills, const FSkillTable& InBossSkills)
+	: Config(InConfig)
+	, PlayerSkills(InPlayerSkills)
+	, BossSkills(InBossSkills)
+{
+}
+
+int32 FCombatSimulator::ChoosePlayerSkill(const FSimFighter& Player, double Now) const
+{
+	int32 BestSkill = PlayerSkills.FallbackSkill;
+	float BestDamage = -1.f;
+	for (int32 SkillId = 0; SkillId < PlayerSkills.Num(); SkillId++)
+	{
+		if (PlayerSkills[SkillId].Damage > BestDamage && TSkillExecutor<FSimFighter>::CanActivate(Player, PlayerSkills, SkillId, Now))
+		{
+			BestSkill = SkillId;
+			BestDamage = PlayerSkills[SkillId].Damage;
+		}
+	}
+	return BestSkill;
+}
+
+FFightResult FCombatSimulator::RunFight(uint64 Seed) const
+{
+	FCombatRandom Random(Seed);
+	FFightResult Result;
+
+	FSimFighter Player;
+	Player.Health = Player.MaxHealth = Config.PlayerMaxHealth;
+	Player.AbilityPoint = FRegeneratingAttribute(FFighterDefaults::MaxAbilityPoint, FFighterDefaults::MaxAbilityPoint, FFighterDefaults::AbilityPointRegenRate, 0.0);
+	Player.HealthPotionCharges = Player.AbilityPointPotionCharges = FFighterDefaults::PotionCharges;
+	Player.DamageScale = Config.PlayerDamageScale;
+
+	FSimFighter Boss;
+	Boss.Health = Boss.MaxHealth = Config.BossMaxHealth;
+	Boss.AbilityPoint = Player.AbilityPoint;
+	Boss.DamageScale = Config.BossDamageScale;
+
+	Player.Target = &Boss;
+	Boss.Target = &Player;
+
+	const double TimeStep = Config.TimeStep;
+	const int64 MaxSteps = (int64)std::ceil(Config.MaxFightTime / TimeStep);
+
+	double PlayerReadyTime = 0.0;
+	double BossReadyTime = 0.0;
+	double BossImpactTime = 0.0;
+	int32 BossPendingSkill = INDEX_NONE;
+
+	int64 Step = 0;
+	while (Step <= MaxSteps)
+	{
+		const double Now = Step * TimeStep;
+		Player.Now = Boss.Now = Now;
+
+		// Boss hit lands
+		if (BossPendingSkill != INDEX_NONE && Now >= BossImpactTime)
+		{
+			TSkillExecutor<FSimFighter>::Execute(Boss, BossSkills[BossPendingSkill], Now);
+			BossPendingSkill = INDEX_NONE;
+			BossReadyTime = Now + Config.BossReengageDelay;
+			Result.BossCasts++;
+			if (Player.Health <= 0.f)
+			{
+				Result.Duration = (float)Now;
+				return Result;
+			}
+		}
+
+		// Boss engages and winds up its next skill
+		if (BossPendingSkill == INDEX_NONE && Now >= BossReadyTime)
+		{
+			const int32 Roll = Random.RandRange(0, BossSkills.Num() - 1);
+			BossPendingSkill = TSkillExecutor<FSimFighter>::ChooseSkill(Boss, BossSkills, Roll, Now);
+			BossImpactTime = Now + BossSkills[BossPendingSkill].WindUp;
+		}
+
+		// Player drinks and attacks
+		if (Player.Health < Config.PlayerHealthPotionThreshold)
+		{
+			FCombatRules::UseHealthPotion(Player.Health, Player.MaxHealth, Player.HealthPotionCharges, Player.Cooldowns, GHealthPotionRules, Now);
+		}
+		if (Player.AbilityPoint.Get(Now) < Config.PlayerAbilityPointPotionThreshold)
+		{
+			FCombatRules::UseAbilityPointPotion(Player.AbilityPoint, Player.AbilityPointPotionCharges, Player.Cooldowns, GAbilityPointPotionRules, Now);
+		}
+		if (Now >= PlayerReadyTime)
+		{
+			const int32 SkillId = ChoosePlayerSkill(Player, Now);
+			PlayerReadyTime = Now + TSkillExecutor<FSimFighter>::Execute(Player, PlayerSkills[SkillId], Now);
+			Result.PlayerCasts++;
+			if (Boss.Health <= 0.f)
+			{
+				Result.bPlayerWon = true;
+				Result.Duration = (float)Now;
+				return Result;
+			}
+		}
+
+		// Skip to the step of the next event, potions are only considered on events
+		const double NextEvent = BossPendingSkill != INDEX_NONE
+			? (BossImpactTime < PlayerReadyTime ? BossImpactTime : PlayerReadyTime)
+			: (BossReadyTime < PlayerReadyTime ? BossReadyTime : PlayerReadyTime);
+		const int64 NextStep = (int64)std::ceil(NextEvent / TimeStep - 1e-6);
+		Step = NextStep > Step ? NextStep : Step + 1;
+	}
+
+	Result.bTimedOut = true;
+	Result.Duration = Config.MaxFightTime;
+	return Result;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "CombatRules.h"
+#include "SkillDefinition.h"
+
+/** Tuning of a simulated fight, the defaults match the game */
+struct FCombatSimConfig
+{
+	/** Simulation quantum in seconds, every event happens on a multiple of it */
+	float TimeStep = 0.05f;
+	/** Fights still running after this many seconds count as timeouts */
+	float MaxFightTime = 600.f;
+	float PlayerMaxHealth = FFighterDefaults::PlayerMaxHealth;
+	float BossMaxHealth = FFighterDefaults::BossMaxHealth;
+	float PlayerDamageScale = 1.f;
+	float BossDamageScale = 1.f;
+	/** Seconds before the boss engages again after a hit, stands for the overlap beginning again in the game */
+	float BossReengageDelay = 0.5f;
+	/** The player drinks potions below these values */
+	float PlayerHealthPotionThreshold = 100.f;
+	float PlayerAbilityPointPotionThreshold = 20.f;
+};
+
+/** A fighter of the simulation, implements the TSkillExecutor interface */
+struct FSimFighter
+{
+	float Health = 0.f;
+	float MaxHealth = 0.f;
+	FRegeneratingAttribute AbilityPoint;
+	FCooldownTracker Cooldowns;
+	float HealthPotionCharges = 0.f;
+	float AbilityPointPotionCharges = 0.f;
+	float DamageScale = 1.f;
+	FSimFighter* Target = nullptr;
+	/** Simulation time, kept here so the executor interface does not need it */
+	double Now = 0.0;
+
+	FORCEINLINE float GetSkillResource() const { return AbilityPoint.Get(Now); }
+	FORCEINLINE void SpendSkillResource(float Amount) { AbilityPoint.Add(-Amount, Now); }
+	FORCEINLINE void ApplySkillDamage(float Damage) { Target->Health -= Damage * DamageScale; }
+	FORCEINLINE FCooldownTracker& GetCooldowns() { return Cooldowns; }
+	FORCEINLINE const FCooldownTracker& GetCooldowns() const { return Cooldowns; }
+};
+
+struct FFightResult
+{
+	bool bPlayerWon = false;
+	bool bTimedOut = false;
+	/** Seconds until one side died */
+	float Duration = 0.f;
+	int32 PlayerCasts = 0;
+	int32 BossCasts = 0;
+};
+
+/**
+ * Fixed-step simulation of one player against one boss in melee range, with the same rules as the actors.
+ * Steps without any event are skipped, so a fight costs a few dozen updates rather than thousands.
+ */
+class FCombatSimulator
+{
+public:
+	FCombatSimulator(const FCombatSimConfig& InConfig, const FSkillTable& InPlayerSkills, const FSkillTable& InBossSkills);
+
+	/** Runs one fight, the same seed always gives the same fight */
+	FFightResult RunFight(uint64 Seed) const;
+
+	const FCombatSimConfig& GetConfig() const { return Config; }
+
+private:
+	/** Player policy: strongest affordable skill, the fallback skill otherwise */
+	int32 ChoosePlayerSkill(const FSimFighter& Player, double Now) const;
+
+	FCombatSimConfig Config;
+	FSkillTable PlayerSkills;
+	FSkillTable BossSkills;
+};
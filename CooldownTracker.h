@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+
+/** Named cooldown slots. Skills added through a skill table may use the slots from Count up to FCooldownTracker::MaxSlots. */
+enum class ECooldownSlot : uint8
+{
+	FirstSkill,
+	SecondSkill,
+	ThirdSkill,
+	HealthPotion,
+	AbilityPointPotion,
+
+	Count
+};
+
+/**
+ * Keeps the world time at which each cooldown expires.
+ * The remaining time is computed when asked, so a running cooldown costs no timer.
+ */
+struct FCooldownTracker
+{
+	static constexpr int32 MaxSlots = 16;
+
+	FCooldownTracker()
+	{
+		Reset();
+	}
+
+	/** Clears every cooldown */
+	void Reset()
+	{
+		for (double& ExpiryTime : ExpiryTimes)
+		{
+			ExpiryTime = 0.0;
+		}
+	}
+
+	/** Starts (or restarts) the cooldown of a slot, Duration in seconds */
+	FORCEINLINE void Start(int32 Slot, double Now, float Duration)
+	{
+		check(Slot >= 0 && Slot < MaxSlots);
+		ExpiryTimes[Slot] = Now + Duration;
+	}
+
+	/** Returns true once the cooldown of a slot has run out */
+	FORCEINLINE bool IsReady(int32 Slot, double Now) const
+	{
+		return Now >= ExpiryTimes[Slot];
+	}
+
+	/** Returns the remaining cooldown of a slot in seconds, 0 when ready */
+	FORCEINLINE float GetRemaining(int32 Slot, double Now) const
+	{
+		return ExpiryTimes[Slot] > Now ? (float)(ExpiryTimes[Slot] - Now) : 0.f;
+	}
+
+	/** Returns the world time at which the cooldown of a slot expires */
+	FORCEINLINE double GetExpiryTime(int32 Slot) const
+	{
+		return ExpiryTimes[Slot];
+	}
+
+	/** Overwrites the expiry time of a slot, used to apply replicated cooldowns */
+	FORCEINLINE void SetExpiryTime(int32 Slot, double ExpiryTime)
+	{
+		check(Slot >= 0 && Slot < MaxSlots);
+		ExpiryTimes[Slot] = ExpiryTime;
+	}
+
+	FORCEINLINE void Start(ECooldownSlot Slot, double Now, float Duration) { Start((int32)Slot, Now, Duration); }
+	FORCEINLINE bool IsReady(ECooldownSlot Slot, double Now) const { return IsReady((int32)Slot, Now); }
+	FORCEINLINE float GetRemaining(ECooldownSlot Slot, double Now) const { return GetRemaining((int32)Slot, Now); }
+	FORCEINLINE double GetExpiryTime(ECooldownSlot Slot) const { return GetExpiryTime((int32)Slot); }
+
+private:
+	double ExpiryTimes[MaxSlots];
+};
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+
+/** One hit waiting in the damage queue */
+struct FDamageHit
+{
+	/** Index of the target in the health arrays */
+	int32 Target;
+	float Amount;
+	/** Unique id of the attacker, for logging */
+	uint32 Source;
+};
+
+/**
+ * Resolves a frame of hits against contiguous health arrays.
+ * Hits are first summed per target in queue order, then every target is updated in one branch-free pass the
+ * compiler can vectorize, so the result does not depend on which attacker ran first and a target hit several times
+ * in a frame only dies once.
+ */
+struct FDamageResolver
+{
+	/** Adds the amount of every hit to the pending damage of its target */
+	static void Accumulate(const FDamageHit* RESTRICT Hits, int32 NumHits, float* RESTRICT PendingDamage)
+	{
+		for (int32 HitIndex = 0; HitIndex < NumHits; HitIndex++)
+		{
+			PendingDamage[Hits[HitIndex].Target] += Hits[HitIndex].Amount;
+		}
+	}
+
+	/**
+	 * Subtracts and clears the pending damage of every target and flags the targets that went from alive to dead.
+	 * Died must hold NumTargets entries.
+	 */
+	static void Apply(float* RESTRICT Health, float* RESTRICT PendingDamage, uint8* RESTRICT Died, int32 NumTargets)
+	{
+		for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++)
+		{
+			const float Before = Health[TargetIndex];
+			const float After = Before - PendingDamage[TargetIndex];
+			Health[TargetIndex] = After;
+			PendingDamage[TargetIndex] = 0.f;
+			Died[TargetIndex] = (uint8)((Before > 0.f) & (After <= 0.f));
+		}
+	}
+
+	/** Writes the indices of the flagged targets to OutDeaths in index order and returns how many there are */
+	static int32 GatherDeaths(const uint8* RESTRICT Died, int32 NumTargets, int32* RESTRICT OutDeaths)
+	{
+		int32 NumDeaths = 0;
+		for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++)
+		{
+			OutDeaths[NumDeaths] = TargetIndex;
+			NumDeaths += Died[TargetIndex];
+		}
+		return NumDeaths;
+	}
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FightRecorder.h"
+#include "FighterAttributes.h"
+#include "SkillDefinition.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	int32 GRecordFights = 0;
+	FAutoConsoleVariableRef CVarRecordFights(
+		TEXT("BossFight.RecordFights"),
+		GRecordFights,
+		TEXT("Records the fights of the worlds started afterwards to Saved/Fights, for CombatSim --replay.\n0: off, 1: on"));
+}
+
+bool FFightRecorder::bRecording = false;
+double FFightRecorder::StartTime = 0.0;
+uint64 FFightRecorder::LastTimeMs = 0;
+int32 FFightRecorder::NumRecords = 0;
+const UWorld* FFightRecorder::RecordedWorld = nullptr;
+FString FFightRecorder::WorldName;
+TArray<uint8> FFightRecorder::Buffer;
+
+void FFightRecorder::BeginWorld(const UWorld& World, uint64 Seed)
+{
+	if (bRecording || !GRecordFights || World.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	bRecording = true;
+	RecordedWorld = &World;
+	StartTime = World.GetTimeSeconds();
+	LastTimeMs = 0;
+	NumRecords = 0;
+	WorldName = World.GetMapName();
+	Buffer.Reset(64 * 1024);
+	Buffer.AddUninitialized(FFightRecordCodec::HeaderSize);
+	FFightRecordCodec::WriteHeader(Buffer.GetData());
+	Record(EFightRecordType::Seed, StartTime, Seed);
+}
+
+void FFightRecorder::EndWorld(const UWorld& World)
+{
+	if (!bRecording || RecordedWorld != &World)
+	{
+		return;
+	}
+	bRecording = false;
+	RecordedWorld = nullptr;
+	// The seed alone is no fight
+	if (NumRecords <= 1)
+	{
+		return;
+	}
+
+	const FString Filename = FPaths::ProjectSavedDir() / TEXT("Fights") / FString::Printf(TEXT("%s_%s.bfr"), *WorldName, *FDateTime::Now().ToString());
+	Async(EAsyncExecution::ThreadPool, [Filename, Data = MoveTemp(Buffer)]()
+	{
+		FFileHelper::SaveArrayToFile(Data, *Filename);
+	});
+	Buffer.Reset();
+}
+
+void FFightRecorder::Record(EFightRecordType Type, double Now, uint64 A, uint64 B)
+{
+	// Events of the same frame may come with clocks a hair apart, keep the stream ordered
+	const uint64 TimeMs = FMath::Max(LastTimeMs, (uint64)FMath::Max(0.0, (Now - StartTime) * 1000.0 + 0.5));
+	const int32 Offset = Buffer.AddUninitialized(FFightRecordCodec::MaxRecordSize);
+	const int32 Written = FFightRecordCodec::Encode({ TimeMs, Type, A, B }, LastTimeMs, Buffer.GetData() + Offset);
+	Buffer.SetNum(Offset + Written, false);
+	LastTimeMs = TimeMs;
+	NumRecords++;
+}
+
+void FFightRecorder::RecordFighter(double Now, uint64 Fighter, const FFighterAttributes& Attributes, const FSkillTable& Skills)
+{
+	const FRegeneratingAttribute& AbilityPoint = Attributes.GetAbilityPointPool();
+	const float Stats[] =
+	{
+		Attributes.GetMaxHealth(),
+		Attributes.GetAttack(),
+		AbilityPoint.GetMaxValue(),
+		AbilityPoint.GetRegenRate(),
+		Attributes.GetHealthPotionCharges(),
+		Attributes.GetAbilityPointPotionCharges(),
+		(float)Skills.Num(),
+		(float)Skills.FallbackSkill,
+	};
+	static_assert(UE_ARRAY_COUNT(Stats) == (int32)EFightStat::Count, "Every stat is recorded");
+	for (int32 StatIndex = 0; StatIndex < (int32)EFightStat::Count; StatIndex++)
+	{
+		Record(EFightRecordType::FighterStat, Now, Fighter, FFightRecordCodec::PackStat((EFightStat)StatIndex, Stats[StatIndex]));
+	}
+
+	for (int32 SkillId = 0; SkillId < Skills.Num(); SkillId++)
+	{
+		const FSkillDefinition& Skill = Skills[SkillId];
+		const float Fields[] = { Skill.Cost, Skill.Damage, Skill.Cooldown, Skill.WindUp, (float)Skill.CooldownSlot };
+		static_assert(UE_ARRAY_COUNT(Fields) == (int32)EFightSkillField::Count, "Every skill field is recorded");
+		for (int32 FieldIndex = 0; FieldIndex < (int32)EFightSkillField::Count; FieldIndex++)
+		{
+			Record(EFightRecordType::FighterSkill, Now, Fighter, FFightRecordCodec::PackSkillField(SkillId, (EFightSkillField)FieldIndex, Fields[FieldIndex]));
+		}
+	}
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FightRecording.h"
+
+struct FFighterAttributes;
+struct FSkillTable;
+
+/**
+ * Records what the outcome of the fights of a world depends on into a compact FFightRecordCodec stream: the boss
+ * random seed, bosses and players joining with their tuning and skill tables and leaving, melee contacts, skills and potions used, the targets of
+ * the boss skills, and deaths.
+ * Movement and physics are not recorded, the contacts they produced are. Server and standalone only, game thread only.
+ * With BossFight.RecordFights 1 every world started afterwards is recorded and written to Saved/Fights when it ends;
+ * the headless CombatSim replays the file with --replay.
+ */
+struct BOSSFIGHT_API FFightRecorder
+{
+	/** Starts recording the world if BossFight.RecordFights is set and no other world is being recorded */
+	static void BeginWorld(const UWorld& World, uint64 Seed);
+	/** Writes the recording of the world to Saved/Fights on the thread pool, worlds without any fight are skipped */
+	static void EndWorld(const UWorld& World);
+
+	static FORCEINLINE bool IsRecording() { return bRecording; }
+	static void Record(EFightRecordType Type, double Now, uint64 A = 0, uint64 B = 0);
+	/** Records the tuning and skill table a fighter joined with, after its Joined record */
+	static void RecordFighter(double Now, uint64 Fighter, const FFighterAttributes& Attributes, const FSkillTable& Skills);
+
+private:
+	static bool bRecording;
+	static double StartTime;
+	static uint64 LastTimeMs;
+	static int32 NumRecords;
+	/** Only compared against, never dereferenced */
+	static const UWorld* RecordedWorld;
+	static FString WorldName;
+	static TArray<uint8> Buffer;
+};
+
+/** Records a fight event when a recording is running, costs one branch otherwise */
+#define FIGHT_RECORD(Type, Now, ...) \
+	do { if (FFightRecorder::IsRecording()) { FFightRecorder::Record((Type), (Now), ##__VA_ARGS__); } } while (0)
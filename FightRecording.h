@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include <cstring>
+
+/** What a fight record stands for, the meaning of A and B depends on it. Fighters are actor unique ids. */
+enum class EFightRecordType : uint8
+{
+	/** A: seed the random streams of the bosses derive from */
+	Seed,
+	/** A: boss, B: index of its random stream */
+	BossJoined,
+	/** A: player */
+	PlayerJoined,
+	/** A: fighter leaving the fight, dead or pooled */
+	Left,
+	/** A: boss, B: player */
+	ContactBegin,
+	ContactEnd,
+	/** A: player, B: skill id. Predicted skills were allowed to arrive early. */
+	Skill,
+	PredictedSkill,
+	/** A: player */
+	HealthPotion,
+	AbilityPointPotion,
+	/** A: fighter, lets a replay check that it went the same way */
+	Death,
+	/** A: boss casting its skill, B: player it lands on, 0 for nobody. Threat depends on frame times, so it is recorded. */
+	BossTarget,
+	/** A: fighter, B: FFightRecordCodec::PackStat of one of its tuning values, written right after it joined */
+	FighterStat,
+	/** A: fighter, B: FFightRecordCodec::PackSkillField of one field of its skill table, written after its stats */
+	FighterSkill,
+
+	Count
+};
+
+/** Tuning values of a fighter carried by FighterStat records */
+enum class EFightStat : uint8
+{
+	MaxHealth,
+	Attack,
+	MaxAbilityPoint,
+	AbilityPointRegenRate,
+	HealthPotionCharges,
+	AbilityPointPotionCharges,
+	/** Size of the skill table, resets it to that many empty skills the FighterSkill records fill */
+	NumSkills,
+	FallbackSkill,
+
+	Count
+};
+
+/** Fields of a skill carried by FighterSkill records */
+enum class EFightSkillField : uint8
+{
+	Cost,
+	Damage,
+	Cooldown,
+	WindUp,
+	CooldownSlot,
+
+	Count
+};
+
+struct FFightRecord
+{
+	/** Milliseconds since the start of the recording */
+	uint64 TimeMs;
+	EFightRecordType Type;
+	uint64 A;
+	uint64 B;
+};
+
+/**
+ * Binary form of a fight recording: FileMagic, then the records one after another. A record is its type byte
+ * followed by the milliseconds since the previous record, A and B as LEB128 varints, 6 to 9 bytes in practice,
+ * 12 for the stats and skills written when a fighter joins.
+ * Plain C++ so the headless replay reads what the game writes.
+ */
+struct FFightRecordCodec
+{
+	/** "BFR1" */
+	static constexpr uint32 FileMagic = 0x31524642;
+	static constexpr int32 HeaderSize = 4;
+	static constexpr int32 MaxRecordSize = 1 + 3 * 10;
+
+	static int32 WriteHeader(uint8* Out)
+	{
+		for (int32 ByteIndex = 0; ByteIndex < HeaderSize; ByteIndex++)
+		{
+			Out[ByteIndex] = (uint8)(FileMagic >> (8 * ByteIndex));
+		}
+		return HeaderSize;
+	}
+
+	static bool ReadHeader(const uint8* Data, int64 Size)
+	{
+		if (Size < HeaderSize)
+		{
+			return false;
+		}
+		uint32 Magic = 0;
+		for (int32 ByteIndex = 0; ByteIndex < HeaderSize; ByteIndex++)
+		{
+			Magic |= (uint32)Data[ByteIndex] << (8 * ByteIndex);
+		}
+		return Magic == FileMagic;
+	}
+
+	/** Writes a record that follows one at PreviousTimeMs, returns the bytes written, at most MaxRecordSize */
+	static int32 Encode(const FFightRecord& Record, uint64 PreviousTimeMs, uint8* Out)
+	{
+		int32 Written = 0;
+		Out[Written++] = (uint8)Record.Type;
+		Written += WriteVarint(Record.TimeMs - PreviousTimeMs, Out + Written);
+		Written += WriteVarint(Record.A, Out + Written);
+		Written += WriteVarint(Record.B, Out + Written);
+		return Written;
+	}
+
+	/** B of a FighterStat record, the value keeps its exact bits */
+	static FORCEINLINE uint64 PackStat(EFightStat Stat, float Value)
+	{
+		return (uint64)FloatToBits(Value) << 8 | (uint64)Stat;
+	}
+
+	static FORCEINLINE void UnpackStat(uint64 Packed, EFightStat& OutStat, float& OutValue)
+	{
+		OutStat = (EFightStat)(uint8)Packed;
+		OutValue = BitsToFloat((uint32)(Packed >> 8));
+	}
+
+	/** B of a FighterSkill record */
+	static FORCEINLINE uint64 PackSkillField(int32 SkillId, EFightSkillField Field, float Value)
+	{
+		return (uint64)FloatToBits(Value) << 16 | (uint64)Field << 8 | (uint64)(uint8)SkillId;
+	}
+
+	static FORCEINLINE void UnpackSkillField(uint64 Packed, int32& OutSkillId, EFightSkillField& OutField, float& OutValue)
+	{
+		OutSkillId = (uint8)Packed;
+		OutField = (EFightSkillField)(uint8)(Packed >> 8);
+		OutValue = BitsToFloat((uint32)(Packed >> 16));
+	}
+
+	/** Reads the record at Offset and moves Offset past it, returns false at the end or on a damaged record */
+	static bool Decode(const uint8* Data, int64 Size, int64& Offset, uint64 PreviousTimeMs, FFightRecord& OutRecord)
+	{
+		if (Offset >= Size || Data[Offset] >= (uint8)EFightRecordType::Count)
+		{
+			return false;
+		}
+		int64 Cursor = Offset;
+		OutRecord.Type = (EFightRecordType)Data[Cursor++];
+		uint64 DeltaMs = 0;
+		if (!ReadVarint(Data, Size, Cursor, DeltaMs) || !ReadVarint(Data, Size, Cursor, OutRecord.A) || !ReadVarint(Data, Size, Cursor, OutRecord.B))
+		{
+			return false;
+		}
+		OutRecord.TimeMs = PreviousTimeMs + DeltaMs;
+		Offset = Cursor;
+		return true;
+	}
+
+private:
+	static FORCEINLINE uint32 FloatToBits(float Value)
+	{
+		uint32 Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	static FORCEINLINE float BitsToFloat(uint32 Bits)
+	{
+		float Value;
+		std::memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	static FORCEINLINE int32 WriteVarint(uint64 Value, uint8* Out)
+	{
+		int32 Written = 0;
+		while (Value >= 0x80)
+		{
+			Out[Written++] = (uint8)(Value | 0x80);
+			Value >>= 7;
+		}
+		Out[Written++] = (uint8)Value;
+		return Written;
+	}
+
+	static FORCEINLINE bool ReadVarint(const uint8* Data, int64 Size, int64& Cursor, uint64& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 64 && Cursor < Size; Shift += 7)
+		{
+			const uint8 Byte = Data[Cursor++];
+			OutValue |= (uint64)(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+};
@@ -0,0 +1,465 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FightReplay.h"
+#include "SkillExecutor.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	struct FReplayFighter : FSimFighter
+	{
+		uint64 Id = 0;
+		bool bBoss = false;
+		/** Cleared when the fighter leaves, a fighter joining again with the same id is a new entry */
+		bool bActive = true;
+		bool bDead = false;
+		bool bDeathRecorded = false;
+		/** Recorded when the fighter joined, the defaults of its side for older recordings */
+		FSkillTable Skills;
+		/** No skill scales with it, in the game either */
+		float Attack = 0.f;
+
+		/** Boss: own random stream, engaged from a contact until its skill landed */
+		FCombatRandom Random;
+		bool bEngaged = false;
+		int32 PendingSkill = INDEX_NONE;
+		double ImpactTime = 0.0;
+
+		/** Player: bosses in reach and end of the wind-up lockout */
+		int32 Contacts = 0;
+		double LockedUntil = 0.0;
+	};
+
+	/** State of one replay */
+	class FReplayRun
+	{
+	public:
+		FReplayRun(const FCombatSimConfig& InConfig, const FSkillTable& InPlayerSkills, const FSkillTable& InBossSkills, FReplayResult& InResult)
+			: Config(InConfig)
+			, PlayerSkills(InPlayerSkills)
+			, BossSkills(InBossSkills)
+			, Result(InResult)
+		{
+			Nobody.Health = Nobody.MaxHealth = 1e30f;
+		}
+
+		void Apply(const FFightRecord& Record)
+		{
+			const double Now = Record.TimeMs / 1000.0;
+			LandBossSkills(Now);
+
+			switch (Record.Type)
+			{
+			case EFightRecordType::Seed:
+				Seed = Record.A;
+				break;
+			case EFightRecordType::BossJoined:
+				Join(Record.A, true, Now).Random = FCombatRandom::ForStream(Seed, Record.B);
+				break;
+			case EFightRecordType::PlayerJoined:
+				Join(Record.A, false, Now);
+				break;
+			case EFightRecordType::Left:
+				Leave(Record.A);
+				break;
+			case EFightRecordType::ContactBegin:
+				BeginContact(Find(Record.A, true), Find(Record.B, false), Now);
+				break;
+			case EFightRecordType::ContactEnd:
+				EndContact(Find(Record.A, true), Find(Record.B, false));
+				break;
+			case EFightRecordType::Skill:
+			case EFightRecordType::PredictedSkill:
+				UseSkill(Find(Record.A, false), (int32)Record.B, Record.Type == EFightRecordType::PredictedSkill ? FFighterDefaults::SkillPredictionTolerance : 0.f, Now);
+				break;
+			case EFightRecordType::HealthPotion:
+			case EFightRecordType::AbilityPointPotion:
+				UsePotion(Find(Record.A, false), Record.Type == EFightRecordType::HealthPotion, Now);
+				break;
+			case EFightRecordType::Death:
+				NoteRecordedDeath(Record.A);
+				break;
+			case EFightRecordType::FighterStat:
+				ApplyStat(FindAny(Record.A), Record.B, Now);
+				break;
+			case EFightRecordType::FighterSkill:
+				ApplySkillField(FindAny(Record.A), Record.B);
+				break;
+			default:
+				break;
+			}
+		}
+
+		/**
+		 * Queues a BossTarget record ahead of the replay: the game writes it on the frame the skill lands, which may come
+		 * after records the skill already landed before, so each boss takes its recorded targets in cast order
+		 */
+		void QueueBossTarget(const FFightRecord& Record)
+		{
+			BossTargets[Record.A].push_back(Record.B);
+		}
+
+		void Finish()
+		{
+			for (const FReplayFighter& Fighter : Fighters)
+			{
+				if (Fighter.bDead && !Fighter.bDeathRecorded)
+				{
+					Result.DeathMismatches++;
+				}
+			}
+		}
+
+	private:
+		FReplayFighter& Join(uint64 Id, bool bBoss, double Now)
+		{
+			FReplayFighter& Fighter = Fighters.emplace_back();
+			Fighter.Id = Id;
+			Fighter.bBoss = bBoss;
+			Fighter.Now = Now;
+			Fighter.Health = Fighter.MaxHealth = bBoss ? Config.BossMaxHealth : Config.PlayerMaxHealth;
+			Fighter.AbilityPoint = FRegeneratingAttribute(FFighterDefaults::MaxAbilityPoint, FFighterDefaults::MaxAbilityPoint, FFighterDefaults::AbilityPointRegenRate, Now);
+			Fighter.HealthPotionCharges = Fighter.AbilityPointPotionCharges = bBoss ? 0.f : FFighterDefaults::PotionCharges;
+			Fighter.DamageScale = bBoss ? Config.BossDamageScale : Config.PlayerDamageScale;
+			Fighter.Skills = bBoss ? BossSkills : PlayerSkills;
+			Fighter.Target = &Nobody;
+			return Fighter;
+		}
+
+		/** The tuning the fighter joined with replaces the defaults Join gave it */
+		void ApplyStat(FReplayFighter* Fighter, uint64 Packed, double Now)
+		{
+			EFightStat Stat;
+			float Value;
+			FFightRecordCodec::UnpackStat(Packed, Stat, Value);
+			if (!Fighter)
+			{
+				return;
+			}
+			switch (Stat)
+			{
+			case EFightStat::MaxHealth:
+				Fighter->Health = Fighter->MaxHealth = Value;
+				break;
+			case EFightStat::Attack:
+				Fighter->Attack = Value;
+				break;
+			case EFightStat::MaxAbilityPoint:
+				Fighter->AbilityPoint = FRegeneratingAttribute(Value, Value, Fighter->AbilityPoint.GetRegenRate(), Now);
+				break;
+			case EFightStat::AbilityPointRegenRate:
+				Fighter->AbilityPoint = FRegeneratingAttribute(Fighter->AbilityPoint.GetMaxValue(), Fighter->AbilityPoint.GetMaxValue(), Value, Now);
+				break;
+			case EFightStat::HealthPotionCharges:
+				Fighter->HealthPotionCharges = Value;
+				break;
+			case EFightStat::AbilityPointPotionCharges:
+				Fighter->AbilityPointPotionCharges = Value;
+				break;
+			case EFightStat::NumSkills:
+				Fighter->Skills.Reset();
+				for (int32 SkillId = 0; SkillId < std::min((int32)Value, FSkillTable::MaxSkills); SkillId++)
+				{
+					Fighter->Skills.Add(FSkillDefinition());
+				}
+				break;
+			case EFightStat::FallbackSkill:
+				Fighter->Skills.FallbackSkill = Fighter->Skills.IsValidSkill((int32)Value) ? (int32)Value : Fighter->Skills.Num() - 1;
+				break;
+			default:
+				break;
+			}
+		}
+
+		void ApplySkillField(FReplayFighter* Fighter, uint64 Packed)
+		{
+			int32 SkillId;
+			EFightSkillField Field;
+			float Value;
+			FFightRecordCodec::UnpackSkillField(Packed, SkillId, Field, Value);
+			if (!Fighter || !Fighter->Skills.IsValidSkill(SkillId))
+			{
+				return;
+			}
+			FSkillDefinition& Skill = Fighter->Skills[SkillId];
+			switch (Field)
+			{
+			case EFightSkillField::Cost:
+				Skill.Cost = Value;
+				break;
+			case EFightSkillField::Damage:
+				Skill.Damage = Value;
+				break;
+			case EFightSkillField::Cooldown:
+				Skill.Cooldown = Value;
+				break;
+			case EFightSkillField::WindUp:
+				Skill.WindUp = Value;
+				break;
+			case EFightSkillField::CooldownSlot:
+				Skill.CooldownSlot = (uint8)std::min((int32)Value, FCooldownTracker::MaxSlots - 1);
+				break;
+			default:
+				break;
+			}
+		}
+
+		/** Active fighter with the id, nullptr if there is none */
+		FReplayFighter* Find(uint64 Id, bool bBoss)
+		{
+			for (auto It = Fighters.rbegin(); It != Fighters.rend(); ++It)
+			{
+				if (It->Id == Id && It->bActive && It->bBoss == bBoss)
+				{
+					return &*It;
+				}
+			}
+			return nullptr;
+		}
+
+		/** Active boss or player with the id, ids are unique across both */
+		FReplayFighter* FindAny(uint64 Id)
+		{
+			FReplayFighter* Fighter = Find(Id, true);
+			return Fighter ? Fighter : Find(Id, false);
+		}
+
+		void Leave(uint64 Id)
+		{
+			FReplayFighter* Fighter = FindAny(Id);
+			if (!Fighter)
+			{
+				return;
+			}
+			// Like UMeleeReachSubsystem: a boss leaving ends its contacts for the players, a player leaving lets go of the
+			// bosses; the ContactEnd records the game writes for a leaving player come after its Left record
+			for (size_t ContactIndex = Contacts.size(); ContactIndex-- > 0;)
+			{
+				if (Contacts[ContactIndex].first == Fighter)
+				{
+					EndContact(Contacts[ContactIndex].first, Contacts[ContactIndex].second);
+				}
+				else if (Contacts[ContactIndex].second == Fighter)
+				{
+					Contacts.erase(Contacts.begin() + ContactIndex);
+				}
+			}
+			for (FReplayFighter& Other : Fighters)
+			{
+				if (Other.Target == Fighter)
+				{
+					Other.Target = &Nobody;
+				}
+			}
+			Fighter->bActive = false;
+			Fighter->PendingSkill = INDEX_NONE;
+		}
+
+		void BeginContact(FReplayFighter* Boss, FReplayFighter* Player, double Now)
+		{
+			if (!Boss || !Player)
+			{
+				return;
+			}
+			Contacts.emplace_back(Boss, Player);
+			if (Player->Contacts++ == 0)
+			{
+				Player->Target = Boss;
+			}
+			if (Boss->bEngaged || Boss->bDead)
+			{
+				return;
+			}
+
+			// AAICharacter::OnMeleeContactBegin and the decision phase of UBossBrainSubsystem
+			Boss->bEngaged = true;
+			Boss->Target = Player;
+			Boss->Now = Now;
+			const int32 Roll = Boss->Random.RandRange(0, Boss->Skills.Num() - 1);
+			const int32 SkillId = TSkillExecutor<FSimFighter>::ChooseSkill(*Boss, Boss->Skills, Roll, Now);
+			if (Boss->Skills.IsValidSkill(SkillId))
+			{
+				Boss->PendingSkill = SkillId;
+				Boss->ImpactTime = Now + Boss->Skills[SkillId].WindUp;
+			}
+		}
+
+		void EndContact(FReplayFighter* Boss, FReplayFighter* Player)
+		{
+			for (size_t ContactIndex = 0; ContactIndex < Contacts.size(); ContactIndex++)
+			{
+				if (Contacts[ContactIndex].first == Boss && Contacts[ContactIndex].second == Player)
+				{
+					Contacts.erase(Contacts.begin() + ContactIndex);
+					break;
+				}
+			}
+			if (!Player || Player->Contacts == 0 || --Player->Contacts == 0 || Player->Target != Boss)
+			{
+				return;
+			}
+			for (const std::pair<FReplayFighter*, FReplayFighter*>& Contact : Contacts)
+			{
+				if (Contact.second == Player)
+				{
+					Player->Target = Contact.first;
+					break;
+				}
+			}
+		}
+
+		/** Lands, in time order, the boss skills whose wind-up ends by Now */
+		void LandBossSkills(double Now)
+		{
+			for (;;)
+			{
+				FReplayFighter* NextBoss = nullptr;
+				for (FReplayFighter& Fighter : Fighters)
+				{
+					if (Fighter.PendingSkill != INDEX_NONE && Fighter.ImpactTime <= Now && (!NextBoss || Fighter.ImpactTime < NextBoss->ImpactTime))
+					{
+						NextBoss = &Fighter;
+					}
+				}
+				if (!NextBoss)
+				{
+					return;
+				}
+
+				// AAICharacter::ExecuteSkill: the skill lands on the top of the threat table instead of the contact player
+				const auto Targets = BossTargets.find(NextBoss->Id);
+				if (Targets != BossTargets.end() && !Targets->second.empty())
+				{
+					FReplayFighter* Player = Targets->second.front() != 0 ? Find(Targets->second.front(), false) : nullptr;
+					NextBoss->Target = Player ? Player : &Nobody;
+					Targets->second.pop_front();
+				}
+
+				const int32 SkillId = NextBoss->PendingSkill;
+				NextBoss->PendingSkill = INDEX_NONE;
+				NextBoss->bEngaged = false;
+				NextBoss->Now = NextBoss->ImpactTime;
+				TSkillExecutor<FSimFighter>::Execute(*NextBoss, NextBoss->Skills[SkillId], NextBoss->ImpactTime);
+				Result.BossCasts++;
+				CheckDeath(*static_cast<FReplayFighter*>(NextBoss->Target));
+			}
+		}
+
+		void UseSkill(FReplayFighter* Player, int32 SkillId, float Tolerance, double Now)
+		{
+			// ABossFightCharacter::CanUseSkill
+			if (!Player || Player->bDead || Player->Contacts == 0 || Player->LockedUntil - Now > Tolerance)
+			{
+				Result.RejectedActions++;
+				return;
+			}
+			Player->Now = Now;
+			if (!TSkillExecutor<FSimFighter>::CanActivate(*Player, Player->Skills, SkillId, Now + Tolerance))
+			{
+				Result.RejectedActions++;
+				return;
+			}
+			const float WindUp = TSkillExecutor<FSimFighter>::Execute(*Player, Player->Skills[SkillId], Now);
+			Player->LockedUntil = Now + WindUp - Tolerance;
+			Result.PlayerCasts++;
+			CheckDeath(*static_cast<FReplayFighter*>(Player->Target));
+		}
+
+		void UsePotion(FReplayFighter* Player, bool bHealth, double Now)
+		{
+			const bool bUsed = Player && !Player->bDead && (bHealth
+				? FCombatRules::UseHealthPotion(Player->Health, Player->MaxHealth, Player->HealthPotionCharges, Player->Cooldowns, GHealthPotionRules, Now)
+				: FCombatRules::UseAbilityPointPotion(Player->AbilityPoint, Player->AbilityPointPotionCharges, Player->Cooldowns, GAbilityPointPotionRules, Now));
+			if (!bUsed)
+			{
+				Result.RejectedActions++;
+			}
+		}
+
+		void CheckDeath(FReplayFighter& Fighter)
+		{
+			if (&Fighter != &Nobody && !Fighter.bDead && Fighter.Health <= 0.f)
+			{
+				Fighter.bDead = true;
+				Fighter.PendingSkill = INDEX_NONE;
+				Result.Deaths++;
+			}
+		}
+
+		void NoteRecordedDeath(uint64 Id)
+		{
+			FReplayFighter* Fighter = FindAny(Id);
+			if (Fighter && Fighter->bDead && !Fighter->bDeathRecorded)
+			{
+				Fighter->bDeathRecorded = true;
+			}
+			else
+			{
+				Result.DeathMismatches++;
+			}
+		}
+
+		const FCombatSimConfig& Config;
+		const FSkillTable& PlayerSkills;
+		const FSkillTable& BossSkills;
+		FReplayResult& Result;
+
+		/** Deque so the fighters never move, they point at each other */
+		std::deque<FReplayFighter> Fighters;
+		/** Boss and player of every contact */
+		std::vector<std::pair<FReplayFighter*, FReplayFighter*>> Contacts;
+		/** Target of fighters whose target left, takes the hits of skills landing on nobody */
+		FReplayFighter Nobody;
+		uint64 Seed = 0;
+		/** Recorded targets of the casts of each boss still to land */
+		std::unordered_map<uint64, std::deque<uint64>> BossTargets;
+	};
+}
+
+FFightReplay::FFightReplay(const FCombatSimConfig& InConfig, const FSkillTable& InPlayerSkills, const FSkillTable& InBossSkills)
+	: Config(InConfig)
+	, PlayerSkills(InPlayerSkills)
+	, BossSkills(InBossSkills)
+{
+}
+
+bool FFightReplay::Run(const uint8* Data, int64 Size, FReplayResult& OutResult) const
+{
+	OutResult = FReplayResult();
+	if (!FFightRecordCodec::ReadHeader(Data, Size))
+	{
+		return false;
+	}
+
+	// Decoded up front, the boss targets are needed before the records that carry them
+	std::vector<FFightRecord> Records;
+	int64 Offset = FFightRecordCodec::HeaderSize;
+	FFightRecord Record = {};
+	uint64 TimeMs = 0;
+	while (FFightRecordCodec::Decode(Data, Size, Offset, TimeMs, Record))
+	{
+		TimeMs = Record.TimeMs;
+		Records.push_back(Record);
+	}
+
+	FReplayRun Run(Config, PlayerSkills, BossSkills, OutResult);
+	for (const FFightRecord& BossTarget : Records)
+	{
+		if (BossTarget.Type == EFightRecordType::BossTarget)
+		{
+			Run.QueueBossTarget(BossTarget);
+		}
+	}
+	for (const FFightRecord& Replayed : Records)
+	{
+		Run.Apply(Replayed);
+		OutResult.Records++;
+	}
+	Run.Finish();
+	OutResult.Duration = TimeMs / 1000.0;
+	return true;
+}
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "CombatSimulator.h"
+#include "FightRecording.h"
+
+struct FReplayResult
+{
+	int32 Records = 0;
+	/** Seconds of game covered by the recording */
+	double Duration = 0.0;
+	int32 PlayerCasts = 0;
+	int32 BossCasts = 0;
+	/** Skills and potions the rules turned down, the game turned them down as well when the replay is faithful */
+	int32 RejectedActions = 0;
+	int32 Deaths = 0;
+	/** Deaths recorded but not replayed, or replayed but not recorded */
+	int32 DeathMismatches = 0;
+};
+
+/**
+ * Re-simulates an FFightRecorder recording with the rules of the actors. Bosses roll their skills from the recorded
+ * seed and stream indices exactly like UBossBrainSubsystem; contacts, skills and potions come from the recording.
+ * Fighters take the tuning and skill tables they joined with from the recording too, the health of the config and the
+ * skill tables given only stand in for recordings without them.
+ * Nothing moves and nothing is rendered, so a recording replays orders of magnitude faster than it was played,
+ * and the same recording is the same workload every time.
+ */
+class FFightReplay
+{
+public:
+	FFightReplay(const FCombatSimConfig& InConfig, const FSkillTable& InPlayerSkills, const FSkillTable& InBossSkills);
+
+	/** Replays a recording, returns false if Data is not one. Records after a damaged one are ignored. */
+	bool Run(const uint8* Data, int64 Size, FReplayResult& OutResult) const;
+
+private:
+	FCombatSimConfig Config;
+	FSkillTable PlayerSkills;
+	FSkillTable BossSkills;
+};
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "CombatRules.h"
+#include "CooldownTracker.h"
+#include "RegeneratingAttribute.h"
+
+/** Attributes of a fighter, each one is a bit of the dirty mask */
+enum class EFighterAttribute : uint8
+{
+	Health,
+	MaxHealth,
+	AbilityPoint,
+	Attack,
+	Cooldowns,
+	HealthPotionCharges,
+	AbilityPointPotionCharges,
+
+	Count
+};
+
+constexpr uint32 FighterAttributeBit(EFighterAttribute Attribute)
+{
+	return 1u << (uint32)Attribute;
+}
+
+constexpr uint32 AllFighterAttributes = (1u << (uint32)EFighterAttribute::Count) - 1;
+
+/**
+ * Everything combat changes on a fighter, in one block aligned to a cache line: health, ability points, attack,
+ * potion charges and the dirty mask share the first line, the cooldown expiry times fill the next two.
+ * Every change sets the bit of the attribute in the dirty mask; whoever publishes the changes (replication, UI,
+ * telemetry) takes the mask once per frame instead of comparing every field.
+ */
+struct alignas(64) FFighterAttributes
+{
+	FFighterAttributes()
+		: Health(0.f)
+		, MaxHealth(0.f)
+		, Attack(0.f)
+		, HealthPotionCharges(0.f)
+		, AbilityPointPotionCharges(0.f)
+		, DirtyMask(0)
+	{
+	}
+
+	/** Full health and ability points, every attribute starts dirty */
+	FFighterAttributes(float InMaxHealth, float InAttack, float InMaxAbilityPoint, float InAbilityPointRegenRate, float InHealthPotionCharges, float InAbilityPointPotionCharges, double Now)
+		: Health(InMaxHealth)
+		, MaxHealth(InMaxHealth)
+		, Attack(InAttack)
+		, HealthPotionCharges(InHealthPotionCharges)
+		, AbilityPointPotionCharges(InAbilityPointPotionCharges)
+		, DirtyMask(AllFighterAttributes)
+		, AbilityPoint(InMaxAbilityPoint, InMaxAbilityPoint, InAbilityPointRegenRate, Now)
+	{
+	}
+
+	FORCEINLINE float GetHealth() const { return Health; }
+	FORCEINLINE float GetMaxHealth() const { return MaxHealth; }
+	FORCEINLINE float GetAttack() const { return Attack; }
+	FORCEINLINE float GetAbilityPoint(double Now) const { return AbilityPoint.Get(Now); }
+	FORCEINLINE const FRegeneratingAttribute& GetAbilityPointPool() const { return AbilityPoint; }
+	FORCEINLINE const FCooldownTracker& GetCooldowns() const { return Cooldowns; }
+	FORCEINLINE float GetHealthPotionCharges() const { return HealthPotionCharges; }
+	FORCEINLINE float GetAbilityPointPotionCharges() const { return AbilityPointPotionCharges; }
+
+	FORCEINLINE void SetHealth(float NewHealth)
+	{
+		if (NewHealth != Health)
+		{
+			Health = NewHealth;
+			MarkDirty(EFighterAttribute::Health);
+		}
+	}
+
+	FORCEINLINE void SetAttack(float NewAttack)
+	{
+		if (NewAttack != Attack)
+		{
+			Attack = NewAttack;
+			MarkDirty(EFighterAttribute::Attack);
+		}
+	}
+
+	/** Regeneration is not a change, only setting or spending ability points is */
+	FORCEINLINE void SetAbilityPoint(float NewAbilityPoint, double Now)
+	{
+		AbilityPoint.Set(NewAbilityPoint, Now);
+		MarkDirty(EFighterAttribute::AbilityPoint);
+	}
+
+	FORCEINLINE void AddAbilityPoint(float Delta, double Now)
+	{
+		AbilityPoint.Add(Delta, Now);
+		MarkDirty(EFighterAttribute::AbilityPoint);
+	}
+
+	/** Replaces the whole pool, to apply replicated or predicted state */
+	FORCEINLINE void SetAbilityPointPool(const FRegeneratingAttribute& NewAbilityPoint)
+	{
+		AbilityPoint = NewAbilityPoint;
+		MarkDirty(EFighterAttribute::AbilityPoint);
+	}
+
+	/** Cooldowns for writing, marks them dirty */
+	FORCEINLINE FCooldownTracker& EditCooldowns()
+	{
+		MarkDirty(EFighterAttribute::Cooldowns);
+		return Cooldowns;
+	}
+
+	/** FCombatRules::UseHealthPotion on this fighter, returns true if a charge was used */
+	bool UseHealthPotion(const FPotionRules& Rules, double Now)
+	{
+		if (!FCombatRules::UseHealthPotion(Health, MaxHealth, HealthPotionCharges, Cooldowns, Rules, Now))
+		{
+			return false;
+		}
+		MarkDirty(FighterAttributeBit(EFighterAttribute::Health) | FighterAttributeBit(EFighterAttribute::HealthPotionCharges) | FighterAttributeBit(EFighterAttribute::Cooldowns));
+		return true;
+	}
+
+	bool UseAbilityPointPotion(const FPotionRules& Rules, double Now)
+	{
+		if (!FCombatRules::UseAbilityPointPotion(AbilityPoint, AbilityPointPotionCharges, Cooldowns, Rules, Now))
+		{
+			return false;
+		}
+		MarkDirty(FighterAttributeBit(EFighterAttribute::AbilityPoint) | FighterAttributeBit(EFighterAttribute::AbilityPointPotionCharges) | FighterAttributeBit(EFighterAttribute::Cooldowns));
+		return true;
+	}
+
+	FORCEINLINE void MarkDirty(EFighterAttribute Attribute) { DirtyMask |= FighterAttributeBit(Attribute); }
+	FORCEINLINE void MarkDirty(uint32 Mask) { DirtyMask |= Mask; }
+	FORCEINLINE uint32 GetDirtyMask() const { return DirtyMask; }
+
+	/** Returns the attributes changed since the last call and clears the mask */
+	FORCEINLINE uint32 TakeDirtyMask()
+	{
+		const uint32 Mask = DirtyMask;
+		DirtyMask = 0;
+		return Mask;
+	}
+
+private:
+	float Health;
+	float MaxHealth;
+	float Attack;
+	float HealthPotionCharges;
+	float AbilityPointPotionCharges;
+	uint32 DirtyMask;
+	FRegeneratingAttribute AbilityPoint;
+	alignas(64) FCooldownTracker Cooldowns;
+};
+
+static_assert(alignof(FFighterAttributes) == 64, "FFighterAttributes must start on a cache line");
+static_assert(sizeof(FFighterAttributes) == 3 * 64, "The scalar attributes must fit in the first cache line");
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FighterPoolSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightCharacter.h"
+#include "BossFightStats.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+
+namespace
+{
+	/** Only the fighter classes of the module know how to leave and rejoin the combat batches */
+	void SetFighterInPool(ACharacter* Fighter, bool bInPool)
+	{
+		if (AAICharacter* Boss = Cast<AAICharacter>(Fighter))
+		{
+			Boss->SetInPool(bInPool);
+		}
+		else if (ABossFightCharacter* Player = Cast<ABossFightCharacter>(Fighter))
+		{
+			Player->SetInPool(bInPool);
+		}
+	}
+}
+
+void UFighterPoolSubsystem::Prewarm(TSubclassOf<ACharacter> Class, int32 Count)
+{
+	if (!Class)
+	{
+		return;
+	}
+	FFighterPoolBucket& Bucket = FreeFighters.FindOrAdd(Class);
+	Bucket.Fighters.Reserve(Count);
+	while (Bucket.Fighters.Num() < Count)
+	{
+		ACharacter* Fighter = SpawnPooled(Class, FTransform::Identity);
+		if (!Fighter)
+		{
+			break;
+		}
+		Bucket.Fighters.Add(Fighter);
+		FBossFightStats::AddPooledFighters(1);
+	}
+}
+
+ACharacter* UFighterPoolSubsystem::Acquire(TSubclassOf<ACharacter> Class, const FTransform& Transform)
+{
+	if (!Class)
+	{
+		return nullptr;
+	}
+
+	ACharacter* Fighter = nullptr;
+	if (FFighterPoolBucket* Bucket = FreeFighters.Find(Class))
+	{
+		// Fighters destroyed while pooled, by a level unload for instance, are skipped
+		while (!Fighter && Bucket->Fighters.Num() > 0)
+		{
+			Fighter = Bucket->Fighters.Pop(false);
+			FBossFightStats::AddPooledFighters(-1);
+			if (!IsValid(Fighter))
+			{
+				Fighter = nullptr;
+			}
+		}
+	}
+	if (!Fighter)
+	{
+		Fighter = SpawnPooled(Class, Transform);
+		if (!Fighter)
+		{
+			return nullptr;
+		}
+	}
+
+	Fighter->SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+	SetPooled(Fighter, false);
+	// Pooled spawns are never auto possessed, a boss needs its AI controller to roam and chase. It keeps it in the pool.
+	if (Fighter->IsA<AAICharacter>() && !Fighter->GetController())
+	{
+		Fighter->SpawnDefaultController();
+	}
+	return Fighter;
+}
+
+void UFighterPoolSubsystem::Release(ACharacter* Fighter)
+{
+	if (!IsValid(Fighter) || !Fighter->HasAuthority())
+	{
+		return;
+	}
+	FFighterPoolBucket& Bucket = FreeFighters.FindOrAdd(Fighter->GetClass());
+	if (Bucket.Fighters.Contains(Fighter))
+	{
+		return;
+	}
+
+	if (Fighter->IsPlayerControlled())
+	{
+		Fighter->GetController()->UnPossess();
+	}
+	SetPooled(Fighter, true);
+	Bucket.Fighters.Add(Fighter);
+	FBossFightStats::AddPooledFighters(1);
+}
+
+int32 UFighterPoolSubsystem::GetNumFree(TSubclassOf<ACharacter> Class) const
+{
+	const FFighterPoolBucket* Bucket = FreeFighters.Find(Class);
+	return Bucket ? Bucket->Fighters.Num() : 0;
+}
+
+ACharacter* UFighterPoolSubsystem::SpawnPooled(TSubclassOf<ACharacter> Class, const FTransform& Transform)
+{
+	ACharacter* Fighter = GetWorld()->SpawnActorDeferred<ACharacter>(Class, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!Fighter)
+	{
+		return nullptr;
+	}
+	FBossFightStats::NoteFighterSpawn();
+
+	// BeginPlay runs in FinishSpawning and reads the flag
+	SetFighterInPool(Fighter, true);
+	Fighter->FinishSpawning(Transform);
+	SetPooled(Fighter, true);
+	return Fighter;
+}
+
+void UFighterPoolSubsystem::SetPooled(ACharacter* Fighter, bool bPooled)
+{
+	UCharacterMovementComponent* Movement = Fighter->GetCharacterMovement();
+	if (bPooled)
+	{
+		Movement->StopMovementImmediately();
+		Movement->Deactivate();
+		// The last state, hidden and pooled, still goes out before the channel goes dormant
+		Fighter->SetNetDormancy(DORM_DormantAll);
+	}
+	else
+	{
+		Fighter->SetNetDormancy(DORM_Awake);
+		Movement->Activate(true);
+	}
+	Fighter->SetActorHiddenInGame(bPooled);
+	Fighter->SetActorEnableCollision(!bPooled);
+	Fighter->SetActorTickEnabled(!bPooled && Fighter->PrimaryActorTick.bCanEverTick);
+	Fighter->GetMesh()->SetComponentTickEnabled(!bPooled);
+
+	SetFighterInPool(Fighter, bPooled);
+}
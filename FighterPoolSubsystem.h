@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FighterPoolSubsystem.generated.h"
+
+class ACharacter;
+
+/** How many fighters of a class are spawned into the pool once the class is loaded */
+USTRUCT(BlueprintType)
+struct FFighterPoolEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Pool")
+	TSoftClassPtr<ACharacter> Class;
+	UPROPERTY(EditAnywhere, Category = "Pool", meta = (ClampMin = "0"))
+	int32 Count = 0;
+};
+
+USTRUCT()
+struct FFighterPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<ACharacter*> Fighters;
+};
+
+/**
+ * Server side pool of bosses and player pawns.
+ * A released fighter is hidden, stops moving, leaves every combat batch and goes dormant on the network; acquiring it
+ * again teleports it, resets it to its class defaults and puts it back into the batches. Fights then cost no
+ * SpawnActor, no component registration and no garbage once the pool is warm.
+ */
+UCLASS()
+class BOSSFIGHT_API UFighterPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Spawns fighters straight into the pool until Count of the class are free */
+	void Prewarm(TSubclassOf<ACharacter> Class, int32 Count);
+
+	/** Takes a free fighter of the class out of the pool, spawns one if none is left. Bosses come with their AI controller. */
+	ACharacter* Acquire(TSubclassOf<ACharacter> Class, const FTransform& Transform);
+	template<class T>
+	T* Acquire(TSubclassOf<T> Class, const FTransform& Transform)
+	{
+		return Cast<T>(Acquire(TSubclassOf<ACharacter>(*Class), Transform));
+	}
+
+	/** Puts a dead or finished fighter back into the pool, players are unpossessed. Server only. */
+	void Release(ACharacter* Fighter);
+
+	/** Fighters of the class waiting in the pool */
+	int32 GetNumFree(TSubclassOf<ACharacter> Class) const;
+
+private:
+	/** Spawns a fighter that begins play already pooled, so it never joins the combat batches */
+	ACharacter* SpawnPooled(TSubclassOf<ACharacter> Class, const FTransform& Transform);
+	/** Turns the actor and its components on or off and tells the fighter */
+	static void SetPooled(ACharacter* Fighter, bool bPooled);
+
+	UPROPERTY()
+	TMap<UClass*, FFighterPoolBucket> FreeFighters;
+};
@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+
+/**
+ * Distance field toward one goal cell on a GridSize x GridSize grid, read by any number of pursuers at O(1) each.
+ * Distances are chamfer steps (5 straight, 7 diagonal) expanded from the goal with a bucket queue, so a build costs
+ * O(cells) however many pursuers read it. A build can be spread over several frames with a cell budget; readers keep
+ * the directions of the last finished build until the next one is done. Diagonal steps never cut a blocked corner and
+ * neighbor cells whose heights differ by more than the max step are not connected.
+ * Fixed size and no allocations, the whole field lives in the object.
+ */
+template<int32 GridSize>
+class TFlowField
+{
+public:
+	static constexpr int32 Size = GridSize;
+	static constexpr int32 NumCells = GridSize * GridSize;
+	/** Direction of cells that are the goal or cannot reach it */
+	static constexpr uint8 NoDirection = 8;
+	static constexpr uint32 StraightCost = 5;
+	static constexpr uint32 DiagonalCost = 7;
+
+	TFlowField()
+	{
+		Reset();
+	}
+
+	/** Blocks every cell and drops the readable field */
+	void Reset()
+	{
+		for (int32 Cell = 0; Cell < NumCells; Cell++)
+		{
+			Walkable[Cell] = 0;
+			Heights[Cell] = 0.f;
+		}
+		bBuilding = false;
+		bReadable = false;
+	}
+
+	static FORCEINLINE bool IsInside(int32 X, int32 Y) { return X >= 0 && Y >= 0 && X < Size && Y < Size; }
+
+	/** Walkability and floor height of a cell, used from the next build on */
+	FORCEINLINE void SetCell(int32 X, int32 Y, bool bWalkable, float Height)
+	{
+		const int32 Cell = Y * Size + X;
+		Walkable[Cell] = (uint8)bWalkable;
+		Heights[Cell] = Height;
+	}
+
+	/** Starts a build toward the goal cell, an unfinished one is dropped */
+	void BeginBuild(int32 InGoalX, int32 InGoalY, float InMaxStep)
+	{
+		check(IsInside(InGoalX, InGoalY));
+		MaxStep = InMaxStep;
+		uint8* RESTRICT Pending = DirectionBuffers[1 - ReadBuffer];
+		for (int32 Cell = 0; Cell < NumCells; Cell++)
+		{
+			Distances[Cell] = Unreached;
+			Pending[Cell] = NoDirection;
+		}
+		for (int32& Head : BucketHeads)
+		{
+			Head = INDEX_NONE;
+		}
+		NumQueued = 0;
+
+		// The goal is seeded even if it is blocked, the player may stand on a cell the sampling missed
+		const int32 Goal = InGoalY * Size + InGoalX;
+		Distances[Goal] = 0;
+		Link(Goal);
+		CurrentDistance = 0;
+		BuildGoalX = InGoalX;
+		BuildGoalY = InGoalY;
+		bBuilding = true;
+	}
+
+	/** Expands cells of the running build while Budget lasts and takes them off it, returns true once it is readable */
+	bool ContinueBuild(int32& Budget)
+	{
+		while (bBuilding && Budget > 0)
+		{
+			if (NumQueued == 0)
+			{
+				ReadBuffer = 1 - ReadBuffer;
+				GoalX = BuildGoalX;
+				GoalY = BuildGoalY;
+				bBuilding = false;
+				bReadable = true;
+				break;
+			}
+
+			const int32 Cell = BucketHeads[CurrentDistance % NumBuckets];
+			if (Cell == INDEX_NONE)
+			{
+				CurrentDistance++;
+				continue;
+			}
+			// With steps of at most NumBuckets - 1 the distance of a cell is final once its bucket comes up
+			Unlink(Cell);
+			Expand(Cell);
+			Budget--;
+		}
+		return bReadable && !bBuilding;
+	}
+
+	FORCEINLINE bool IsBuilding() const { return bBuilding; }
+	/** True once a build finished */
+	FORCEINLINE bool IsReadable() const { return bReadable; }
+	/** Goal cell of the readable field */
+	FORCEINLINE int32 GetGoalX() const { return GoalX; }
+	FORCEINLINE int32 GetGoalY() const { return GoalY; }
+
+	/** Direction of the next step from a cell of the readable field, NoDirection at the goal or where it is unreachable */
+	FORCEINLINE uint8 GetDirection(int32 X, int32 Y) const
+	{
+		return bReadable && IsInside(X, Y) ? DirectionBuffers[ReadBuffer][Y * Size + X] : NoDirection;
+	}
+
+	/** Cell offset of a direction, 0 for NoDirection */
+	static FORCEINLINE int32 GetStepX(uint8 Direction) { return StepX[Direction]; }
+	static FORCEINLINE int32 GetStepY(uint8 Direction) { return StepY[Direction]; }
+
+private:
+	static constexpr uint32 Unreached = 0xFFFFFFFFu;
+	/** Larger than the largest step, so the buckets in use never wrap onto each other */
+	static constexpr uint32 NumBuckets = DiagonalCost + 1;
+	/** Straight steps first, then diagonals; Opposite[D] walks D backwards */
+	static constexpr int32 StepX[] = { 1, -1, 0, 0, 1, 1, -1, -1, 0 };
+	static constexpr int32 StepY[] = { 0, 0, 1, -1, 1, -1, 1, -1, 0 };
+	static constexpr uint8 Opposite[] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+
+	void Expand(int32 Cell)
+	{
+		const int32 X = Cell % Size;
+		const int32 Y = Cell / Size;
+		const float Height = Heights[Cell];
+		uint8* RESTRICT Pending = DirectionBuffers[1 - ReadBuffer];
+		for (uint8 Direction = 0; Direction < 8; Direction++)
+		{
+			const int32 NextX = X + StepX[Direction];
+			const int32 NextY = Y + StepY[Direction];
+			if (!IsInside(NextX, NextY))
+			{
+				continue;
+			}
+			const int32 Next = NextY * Size + NextX;
+			if (!Walkable[Next] || Heights[Next] - Height > MaxStep || Height - Heights[Next] > MaxStep)
+			{
+				continue;
+			}
+			const bool bDiagonal = Direction >= 4;
+			if (bDiagonal && (!Walkable[Y * Size + NextX] || !Walkable[NextY * Size + X]))
+			{
+				continue;
+			}
+			const uint32 NextDistance = CurrentDistance + (bDiagonal ? DiagonalCost : StraightCost);
+			if (NextDistance < Distances[Next])
+			{
+				// A reached cell is still queued, move it to its new bucket
+				if (Distances[Next] != Unreached)
+				{
+					Unlink(Next);
+				}
+				Distances[Next] = NextDistance;
+				// Pursuers walk the expansion backwards
+				Pending[Next] = Opposite[Direction];
+				Link(Next);
+			}
+		}
+	}
+
+	/** Buckets are intrusive doubly linked lists through the cells, a cell is in at most one */
+	FORCEINLINE void Link(int32 Cell)
+	{
+		int32& Head = BucketHeads[Distances[Cell] % NumBuckets];
+		PrevQueued[Cell] = INDEX_NONE;
+		NextQueued[Cell] = Head;
+		if (Head != INDEX_NONE)
+		{
+			PrevQueued[Head] = Cell;
+		}
+		Head = Cell;
+		NumQueued++;
+	}
+
+	FORCEINLINE void Unlink(int32 Cell)
+	{
+		const int32 Prev = PrevQueued[Cell];
+		const int32 Next = NextQueued[Cell];
+		if (Prev != INDEX_NONE)
+		{
+			NextQueued[Prev] = Next;
+		}
+		else
+		{
+			BucketHeads[Distances[Cell] % NumBuckets] = Next;
+		}
+		if (Next != INDEX_NONE)
+		{
+			PrevQueued[Next] = Prev;
+		}
+		NumQueued--;
+	}
+
+	uint8 Walkable[NumCells];
+	float Heights[NumCells];
+	float MaxStep = 0.f;
+
+	/** State of the running build */
+	uint32 Distances[NumCells];
+	int32 PrevQueued[NumCells];
+	int32 NextQueued[NumCells];
+	int32 BucketHeads[NumBuckets];
+	int32 NumQueued = 0;
+	uint32 CurrentDistance = 0;
+	int32 BuildGoalX = 0;
+	int32 BuildGoalY = 0;
+	bool bBuilding = false;
+
+	/** The readable directions and the ones of the running build */
+	uint8 DirectionBuffers[2][NumCells];
+	int32 ReadBuffer = 0;
+	int32 GoalX = 0;
+	int32 GoalY = 0;
+	bool bReadable = false;
+};
@@ -0,0 +1,383 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LoadTestSubsystem.h"
+#include "AICharacter.h"
+#include "AIController.h"
+#include "BossBrainSubsystem.h"
+#include "BossFightCharacter.h"
+#include "BossFightGameMode.h"
+#include "BossFightStats.h"
+#include "FighterPoolSubsystem.h"
+#include "StartupLoadSubsystem.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerStart.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	/** Nearest rank percentile of sorted samples, the same rank CombatSim uses */
+	float Percentile(const TArray<float>& Sorted, double Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[(int32)(Fraction * (double)(Sorted.Num() - 1))] : 0.f;
+	}
+
+	double Sum(const TArray<float>& Samples)
+	{
+		double Total = 0.0;
+		for (const float Sample : Samples)
+		{
+			Total += Sample;
+		}
+		return Total;
+	}
+
+	FORCEINLINE double ToMegabytes(uint64 Bytes)
+	{
+		return (double)Bytes / (1024.0 * 1024.0);
+	}
+}
+
+void FLoadTestSettings::ParseCommandLine(const TCHAR* CommandLine)
+{
+	FParse::Value(CommandLine, TEXT("LoadTestBosses="), NumBosses);
+	FParse::Value(CommandLine, TEXT("LoadTestBots="), NumBots);
+	FParse::Value(CommandLine, TEXT("LoadTestWarmUp="), WarmUp);
+	FParse::Value(CommandLine, TEXT("LoadTestDuration="), Duration);
+	FParse::Value(CommandLine, TEXT("LoadTestSpacing="), Spacing);
+	FParse::Value(CommandLine, TEXT("LoadTestSkillInterval="), SkillInterval);
+	FParse::Value(CommandLine, TEXT("LoadTestOut="), OutputPath);
+
+	// Bots need a boss to run to
+	NumBosses = FMath::Max(NumBosses, 1);
+	NumBots = FMath::Max(NumBots, 0);
+	WarmUp = FMath::Max(WarmUp, 0.f);
+	Duration = FMath::Max(Duration, 1.f);
+	SkillInterval = FMath::Max(SkillInterval, 0.1f);
+}
+
+bool ULoadTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && FParse::Param(FCommandLine::Get(), TEXT("BossFightLoadTest"));
+}
+
+bool ULoadTestSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// The test exits the process when it is done, never in the editor
+	return WorldType == EWorldType::Game;
+}
+
+void ULoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Settings.ParseCommandLine(FCommandLine::Get());
+	Phase = EPhase::Loading;
+	PhaseStartTime = 0.0;
+	BotClass = nullptr;
+	GridOrigin = FVector::ZeroVector;
+	NumRespawns = 0;
+	FrameStartTime = 0.0;
+	GCStartTime = 0.0;
+	ActiveTimersSum = 0;
+	MaxActiveTimers = 0;
+	NavQueriesAtStart = 0;
+	PeakUsedPhysical = 0;
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddUObject(this, &ULoadTestSubsystem::OnBeginFrame);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &ULoadTestSubsystem::OnEndFrame);
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &ULoadTestSubsystem::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ULoadTestSubsystem::OnPostGarbageCollect);
+}
+
+void ULoadTestSubsystem::Deinitialize()
+{
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	Super::Deinitialize();
+}
+
+void ULoadTestSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Fighters only come out of the pool on the server
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+	UStartupLoadSubsystem* StartupLoads = InWorld.GetSubsystem<UStartupLoadSubsystem>();
+	StartupLoads->CallWhenDone(EStartupStage::PlayerPawn, FSimpleDelegate::CreateUObject(this, &ULoadTestSubsystem::OnStartupStageDone));
+	StartupLoads->CallWhenDone(EStartupStage::Fighters, FSimpleDelegate::CreateUObject(this, &ULoadTestSubsystem::OnStartupStageDone));
+}
+
+void ULoadTestSubsystem::OnStartupStageDone()
+{
+	const UStartupLoadSubsystem* StartupLoads = GetWorld()->GetSubsystem<UStartupLoadSubsystem>();
+	if (Phase != EPhase::Loading || !StartupLoads->IsDone(EStartupStage::PlayerPawn) || !StartupLoads->IsDone(EStartupStage::Fighters))
+	{
+		return;
+	}
+
+	const ABossFightGameMode* GameMode = GetWorld()->GetAuthGameMode<ABossFightGameMode>();
+	if (!GameMode)
+	{
+		Abort(TEXT("the map does not run BossFightGameMode"));
+		return;
+	}
+	for (const TSoftClassPtr<AAICharacter>& BossClass : GameMode->BossClasses)
+	{
+		if (UClass* Class = BossClass.Get())
+		{
+			BossClasses.Add(Class);
+		}
+	}
+	UClass* PawnClass = GameMode->PlayerPawnClass.Get();
+	BotClass = PawnClass && PawnClass->IsChildOf<ABossFightCharacter>() ? PawnClass : nullptr;
+	if (BossClasses.Num() == 0 || !BotClass)
+	{
+		Abort(TEXT("the game mode lists no loaded boss class or its player pawn is no BossFightCharacter"));
+		return;
+	}
+
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		GridOrigin = It->GetActorLocation();
+		break;
+	}
+	// Bots roll from the boss seed, BossFight.Seed replays a run
+	Random = FCombatRandom::ForStream(GetWorld()->GetSubsystem<UBossBrainSubsystem>()->GetSeed(), MAX_uint32);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	Bosses.SetNumZeroed(Settings.NumBosses);
+	for (int32 BossIndex = 0; BossIndex < Bosses.Num(); BossIndex++)
+	{
+		Bosses[BossIndex] = AcquireBoss(BossIndex);
+	}
+	Bots.SetNumZeroed(Settings.NumBots);
+	NextDecisionTimes.SetNum(Settings.NumBots);
+	for (int32 BotIndex = 0; BotIndex < Bots.Num(); BotIndex++)
+	{
+		Bots[BotIndex] = AcquireBot(BotIndex);
+		NextDecisionTimes[BotIndex] = Now + Settings.SkillInterval * BotIndex / Bots.Num();
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Load test started with %d bosses and %d bots, measuring %.0fs after a %.0fs warm-up"),
+		Settings.NumBosses, Settings.NumBots, Settings.Duration, Settings.WarmUp);
+	Phase = EPhase::WarmingUp;
+	PhaseStartTime = FPlatformTime::Seconds();
+}
+
+AAICharacter* ULoadTestSubsystem::AcquireBoss(int32 BossIndex)
+{
+	const FTransform Transform(FRotator(0.f, 360.f * Random.FRand(), 0.f), GetSpawnLocation(BossIndex));
+	TSubclassOf<AAICharacter> Class = BossClasses[BossIndex % BossClasses.Num()];
+	return GetWorld()->GetSubsystem<UFighterPoolSubsystem>()->Acquire(Class, Transform);
+}
+
+ABossFightCharacter* ULoadTestSubsystem::AcquireBot(int32 BotIndex)
+{
+	// Around their boss, a little outside melee reach
+	const FVector Offset = FVector(Settings.Spacing * 0.4f, 0.f, 0.f).RotateAngleAxis(360.f * Random.FRand(), FVector::UpVector);
+	const FTransform Transform(GetSpawnLocation(BotIndex % Settings.NumBosses) + Offset);
+	TSubclassOf<ABossFightCharacter> Class = BotClass;
+	ABossFightCharacter* Bot = GetWorld()->GetSubsystem<UFighterPoolSubsystem>()->Acquire(Class, Transform);
+	if (Bot && !Bot->GetController())
+	{
+		// Movement input is only consumed from a controlled pawn, a plain AI controller does without a connection
+		if (!Bot->AIControllerClass)
+		{
+			Bot->AIControllerClass = AAIController::StaticClass();
+		}
+		Bot->SpawnDefaultController();
+	}
+	return Bot;
+}
+
+FVector ULoadTestSubsystem::GetSpawnLocation(int32 BossIndex) const
+{
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt((float)Settings.NumBosses));
+	const int32 Rows = (Settings.NumBosses + Columns - 1) / Columns;
+	const float X = (BossIndex % Columns - (Columns - 1) * 0.5f) * Settings.Spacing;
+	const float Y = (BossIndex / Columns - (Rows - 1) * 0.5f) * Settings.Spacing;
+	return GridOrigin + FVector(X, Y, 0.f);
+}
+
+void ULoadTestSubsystem::DriveFighters(double Now)
+{
+	for (int32 BossIndex = 0; BossIndex < Bosses.Num(); BossIndex++)
+	{
+		if (!IsValid(Bosses[BossIndex]) || Bosses[BossIndex]->IsInPool())
+		{
+			Bosses[BossIndex] = AcquireBoss(BossIndex);
+			NumRespawns++;
+		}
+	}
+
+	for (int32 BotIndex = 0; BotIndex < Bots.Num(); BotIndex++)
+	{
+		ABossFightCharacter*& Bot = Bots[BotIndex];
+		if (!IsValid(Bot) || Bot->IsInPool())
+		{
+			Bot = AcquireBot(BotIndex);
+			NumRespawns++;
+		}
+		const AAICharacter* Boss = Bosses[BotIndex % Bosses.Num()];
+		if (!Bot || !Boss)
+		{
+			continue;
+		}
+
+		if (!Bot->IsInMeleeReach())
+		{
+			Bot->AddMovementInput((Boss->GetActorLocation() - Bot->GetActorLocation()).GetSafeNormal2D());
+		}
+		if (Now < NextDecisionTimes[BotIndex])
+		{
+			continue;
+		}
+		NextDecisionTimes[BotIndex] = Now + Settings.SkillInterval;
+
+		const FFighterAttributes& Attributes = Bot->GetAttributes();
+		if (Attributes.GetHealth() < Attributes.GetMaxHealth() * 0.5f && Attributes.GetHealthPotionCharges() >= 1.f)
+		{
+			Bot->UseHealthPotion();
+		}
+		else if (Bot->IsInMeleeReach() && Bot->GetNumSkills() > 0)
+		{
+			Bot->UseSkill(Random.RandRange(0, Bot->GetNumSkills() - 1));
+		}
+	}
+}
+
+void ULoadTestSubsystem::OnBeginFrame()
+{
+	FrameStartTime = FPlatformTime::Seconds();
+}
+
+void ULoadTestSubsystem::OnEndFrame()
+{
+	if (Phase == EPhase::Measuring && FrameStartTime > 0.0)
+	{
+		// A server waiting for its tick rate is not busy
+		const double Busy = FPlatformTime::Seconds() - FrameStartTime - FApp::GetIdleTime();
+		FrameTimes.Add((float)(FMath::Max(Busy, 0.0) * 1000.0));
+	}
+}
+
+void ULoadTestSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void ULoadTestSubsystem::OnPostGarbageCollect()
+{
+	if (Phase == EPhase::Measuring && GCStartTime > 0.0)
+	{
+		GCPauses.Add((float)((FPlatformTime::Seconds() - GCStartTime) * 1000.0));
+	}
+	GCStartTime = 0.0;
+}
+
+void ULoadTestSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ULoadTestSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	if (Phase == EPhase::Loading || Phase == EPhase::Done)
+	{
+		return;
+	}
+	DriveFighters(GetWorld()->GetTimeSeconds());
+
+	const double Now = FPlatformTime::Seconds();
+	if (Phase == EPhase::WarmingUp)
+	{
+		if (Now - PhaseStartTime >= Settings.WarmUp)
+		{
+			Phase = EPhase::Measuring;
+			PhaseStartTime = Now;
+			NavQueriesAtStart = FBossFightStats::GetNavQueriesTotal();
+			NumRespawns = 0;
+			FrameTimes.Reserve(FMath::CeilToInt(Settings.Duration * 120.f));
+		}
+		return;
+	}
+
+	const int32 ActiveTimers = FBossFightStats::GetActiveTimers();
+	ActiveTimersSum += ActiveTimers;
+	MaxActiveTimers = FMath::Max(MaxActiveTimers, ActiveTimers);
+	// Reading the process memory is a system call, every 30 frames is plenty next to the OS peak
+	if (FrameTimes.Num() % 30 == 0)
+	{
+		PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+	}
+
+	if (Now - PhaseStartTime >= Settings.Duration)
+	{
+		Finish();
+	}
+}
+
+TStatId ULoadTestSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_LoadTestTick);
+}
+
+FString ULoadTestSubsystem::BuildReport() const
+{
+	const double Seconds = FPlatformTime::Seconds() - PhaseStartTime;
+	TArray<float> SortedFrames = FrameTimes;
+	SortedFrames.Sort();
+	TArray<float> SortedPauses = GCPauses;
+	SortedPauses.Sort();
+	const int32 NumFrames = FMath::Max(FrameTimes.Num(), 1);
+	const int32 NavQueries = FBossFightStats::GetNavQueriesTotal() - NavQueriesAtStart;
+	const FPlatformMemoryStats Memory = FPlatformMemory::GetStats();
+
+	// One line like CombatBench, so runs of two builds can be diffed
+	return FString::Printf(TEXT("{\"map\":\"%s\",\"bosses\":%d,\"bots\":%d,\"seconds\":%.1f,\"frames\":%d,")
+		TEXT("\"game_thread_ms_mean\":%.3f,\"game_thread_ms_p50\":%.3f,\"game_thread_ms_p95\":%.3f,\"game_thread_ms_p99\":%.3f,\"game_thread_ms_max\":%.3f,")
+		TEXT("\"active_timers_mean\":%.1f,\"active_timers_max\":%d,\"nav_queries\":%d,\"nav_queries_per_second\":%.1f,")
+		TEXT("\"memory_peak_mb\":%.1f,\"memory_sampled_peak_mb\":%.1f,")
+		TEXT("\"gc_count\":%d,\"gc_ms_total\":%.3f,\"gc_ms_p50\":%.3f,\"gc_ms_max\":%.3f,\"respawns\":%d}"),
+		*GetWorld()->GetMapName(), Settings.NumBosses, Settings.NumBots, Seconds, FrameTimes.Num(),
+		Sum(FrameTimes) / NumFrames, Percentile(SortedFrames, 0.50), Percentile(SortedFrames, 0.95), Percentile(SortedFrames, 0.99), Percentile(SortedFrames, 1.0),
+		(double)ActiveTimersSum / NumFrames, MaxActiveTimers, NavQueries, NavQueries / FMath::Max(Seconds, 1.0),
+		ToMegabytes(Memory.PeakUsedPhysical), ToMegabytes(FMath::Max<uint64>(PeakUsedPhysical, Memory.UsedPhysical)),
+		GCPauses.Num(), Sum(GCPauses), Percentile(SortedPauses, 0.50), Percentile(SortedPauses, 1.0), NumRespawns);
+}
+
+void ULoadTestSubsystem::Finish()
+{
+	Phase = EPhase::Done;
+	const FString Report = BuildReport();
+	const FString Filename = !Settings.OutputPath.IsEmpty() ? Settings.OutputPath
+		: FPaths::ProjectSavedDir() / TEXT("LoadTest") / FString::Printf(TEXT("%s_%s.json"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+
+	UE_LOG(LogTemp, Display, TEXT("Load test done: %s"), *Report);
+	if (!FFileHelper::SaveStringToFile(Report + TEXT("\n"), *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cannot write the load test report to %s"), *Filename);
+		FPlatformMisc::RequestExitWithStatus(false, 1);
+		return;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Load test report written to %s"), *Filename);
+	FPlatformMisc::RequestExit(false);
+}
+
+void ULoadTestSubsystem::Abort(const TCHAR* Reason)
+{
+	Phase = EPhase::Done;
+	UE_LOG(LogTemp, Error, TEXT("Load test aborted: %s"), Reason);
+	FPlatformMisc::RequestExitWithStatus(false, 1);
+}
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRules.h"
+#include "LoadTestSubsystem.generated.h"
+
+class AAICharacter;
+class ABossFightCharacter;
+
+/** Shape of a load test, read from the command line */
+struct FLoadTestSettings
+{
+	/** -LoadTestBosses= */
+	int32 NumBosses = 100;
+	/** -LoadTestBots=, scripted player pawns spread over the bosses */
+	int32 NumBots = 100;
+	/** -LoadTestWarmUp=, seconds run before measuring so spawning and the first pathing are left out */
+	float WarmUp = 10.f;
+	/** -LoadTestDuration=, seconds measured */
+	float Duration = 60.f;
+	/** -LoadTestSpacing=, distance between two bosses of the spawn grid */
+	float Spacing = 800.f;
+	/** -LoadTestSkillInterval=, seconds between two decisions of a bot */
+	float SkillInterval = 1.f;
+	/** -LoadTestOut=, defaults to Saved/LoadTest/<map>_<date>.json */
+	FString OutputPath;
+
+	void ParseCommandLine(const TCHAR* CommandLine);
+};
+
+/**
+ * Headless load test of the module, only created with -BossFightLoadTest on the command line, for instance
+ * `BossFightServer Arena -log -nullrhi -BossFightLoadTest -LoadTestBosses=500 -LoadTestBots=200`.
+ * Once the fighter classes are loaded it takes bosses of the game mode's BossClasses and bots of its PlayerPawnClass out
+ * of UFighterPoolSubsystem on a grid around the first player start. Bots are possessed by a plain AI controller, run to
+ * their boss, use a random skill when in reach and a health potion below half health; dead fighters are taken out of
+ * the pool again so the population stays constant. After the warm-up it samples the game thread time of every frame
+ * (idle time waiting for the tick rate left out), the active gameplay timers, the navigation queries, the peak memory
+ * and the garbage collection pauses, writes them as one JSON object and exits.
+ */
+UCLASS()
+class BOSSFIGHT_API ULoadTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** Waits for the fighter classes, then spawns the fighters */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class EPhase : uint8
+	{
+		Loading,
+		WarmingUp,
+		Measuring,
+		Done
+	};
+
+	/** Spawns the fighters once both the player pawn and the fighter classes are in */
+	void OnStartupStageDone();
+	AAICharacter* AcquireBoss(int32 BossIndex);
+	ABossFightCharacter* AcquireBot(int32 BotIndex);
+	FVector GetSpawnLocation(int32 BossIndex) const;
+	/** Takes dead fighters out of the pool again and plays the bots */
+	void DriveFighters(double Now);
+
+	void OnBeginFrame();
+	void OnEndFrame();
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	/** Writes the report and asks the engine to exit */
+	void Finish();
+	FString BuildReport() const;
+	/** Fails the run without a report, for maps the test cannot run on */
+	void Abort(const TCHAR* Reason);
+
+	FLoadTestSettings Settings;
+	EPhase Phase;
+	double PhaseStartTime;
+
+	UPROPERTY()
+	TArray<AAICharacter*> Bosses;
+	UPROPERTY()
+	TArray<ABossFightCharacter*> Bots;
+	/** Time of the next skill or potion of each bot, staggered so the bots do not all decide in the same frame */
+	TArray<double> NextDecisionTimes;
+	UPROPERTY()
+	TArray<UClass*> BossClasses;
+	UPROPERTY()
+	UClass* BotClass;
+	FVector GridOrigin;
+	FCombatRandom Random;
+	int32 NumRespawns;
+
+	/** Game thread milliseconds of each measured frame */
+	TArray<float> FrameTimes;
+	/** Milliseconds of each garbage collection during the measurement */
+	TArray<float> GCPauses;
+	double FrameStartTime;
+	double GCStartTime;
+	int64 ActiveTimersSum;
+	int32 MaxActiveTimers;
+	int32 NavQueriesAtStart;
+	uint64 PeakUsedPhysical;
+
+	FDelegateHandle BeginFrameHandle;
+	FDelegateHandle EndFrameHandle;
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MeleeReachSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightCharacter.h"
+#include "BossFightStats.h"
+#include "FightRecorder.h"
+#include "Engine/World.h"
+#include "WorldCollision.h"
+
+void UMeleeReachSubsystem::RegisterBoss(AAICharacter* Boss)
+{
+	check(Boss);
+	Boss->MeleeIndex = Bosses.Add(Boss);
+	PendingQueries.AddDefaulted();
+}
+
+void UMeleeReachSubsystem::UnregisterBoss(AAICharacter* Boss)
+{
+	const int32 BossIndex = Boss ? Boss->MeleeIndex : INDEX_NONE;
+	if (!Bosses.IsValidIndex(BossIndex) || Bosses[BossIndex] != Boss)
+	{
+		return;
+	}
+
+	Bosses.RemoveAtSwap(BossIndex, 1, false);
+	PendingQueries.RemoveAtSwap(BossIndex, 1, false);
+	if (Bosses.IsValidIndex(BossIndex))
+	{
+		Bosses[BossIndex]->MeleeIndex = BossIndex;
+	}
+	Boss->MeleeIndex = INDEX_NONE;
+
+	// The players still in reach lose this boss
+	for (int32 ContactIndex = Contacts.Num() - 1; ContactIndex >= 0; ContactIndex--)
+	{
+		const FMeleeContact Contact = Contacts[ContactIndex];
+		if (Contact.Boss == Boss)
+		{
+			Contacts.RemoveAt(ContactIndex, 1, false);
+			Contact.Player->OnMeleeContactEnd(Boss);
+		}
+	}
+}
+
+void UMeleeReachSubsystem::RemovePlayer(ABossFightCharacter* Player)
+{
+	// Removed before the callbacks so FindBossInReach no longer sees them. A local list, this may run from a callback
+	TArray<AAICharacter*, TInlineAllocator<8>> ContactBosses;
+	for (int32 ContactIndex = Contacts.Num() - 1; ContactIndex >= 0; ContactIndex--)
+	{
+		if (Contacts[ContactIndex].Player == Player)
+		{
+			ContactBosses.Add(Contacts[ContactIndex].Boss);
+			Contacts.RemoveAt(ContactIndex, 1, false);
+		}
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (AAICharacter* Boss : ContactBosses)
+	{
+		if (Boss)
+		{
+			FIGHT_RECORD(EFightRecordType::ContactEnd, Now, Boss->GetUniqueID(), Player->GetUniqueID());
+		}
+		Player->OnMeleeContactEnd(Boss);
+		if (IsValid(Boss))
+		{
+			Boss->OnPlayerLeft(Player);
+		}
+	}
+}
+
+AAICharacter* UMeleeReachSubsystem::FindBossInReach(const ABossFightCharacter* Player) const
+{
+	for (const FMeleeContact& Contact : Contacts)
+	{
+		if (Contact.Player == Player)
+		{
+			return Contact.Boss;
+		}
+	}
+	return nullptr;
+}
+
+void UMeleeReachSubsystem::GatherContacts()
+{
+	UWorld* World = GetWorld();
+	FOverlapDatum Datum;
+
+	NewContacts.Reset();
+	for (int32 BossIndex = 0; BossIndex < Bosses.Num(); BossIndex++)
+	{
+		AAICharacter* Boss = Bosses[BossIndex];
+		if (!PendingQueries[BossIndex].IsValid() || !World->QueryOverlapData(PendingQueries[BossIndex], Datum))
+		{
+			// No result yet, the boss keeps its contacts
+			for (const FMeleeContact& Contact : Contacts)
+			{
+				if (Contact.Boss == Boss)
+				{
+					NewContacts.Add(Contact);
+				}
+			}
+			continue;
+		}
+
+		for (const FOverlapResult& Overlap : Datum.OutOverlaps)
+		{
+			if (ABossFightCharacter* Player = Cast<ABossFightCharacter>(Overlap.GetActor()))
+			{
+				NewContacts.Add({ Boss, Player });
+			}
+		}
+	}
+
+	// A player overlapping with several components shows up several times
+	NewContacts.Sort();
+	for (int32 ContactIndex = NewContacts.Num() - 1; ContactIndex > 0; ContactIndex--)
+	{
+		if (NewContacts[ContactIndex] == NewContacts[ContactIndex - 1])
+		{
+			NewContacts.RemoveAt(ContactIndex, 1, false);
+		}
+	}
+}
+
+void UMeleeReachSubsystem::DispatchContactChanges()
+{
+	// Both tables are sorted, walk them together
+	BeganContacts.Reset();
+	EndedContacts.Reset();
+	int32 OldIndex = 0;
+	int32 NewIndex = 0;
+	while (OldIndex < Contacts.Num() || NewIndex < NewContacts.Num())
+	{
+		if (NewIndex == NewContacts.Num() || (OldIndex < Contacts.Num() && Contacts[OldIndex] < NewContacts[NewIndex]))
+		{
+			EndedContacts.Add(Contacts[OldIndex++]);
+		}
+		else if (OldIndex == Contacts.Num() || NewContacts[NewIndex] < Contacts[OldIndex])
+		{
+			BeganContacts.Add(NewContacts[NewIndex++]);
+		}
+		else
+		{
+			OldIndex++;
+			NewIndex++;
+		}
+	}
+	Swap(Contacts, NewContacts);
+
+	if (FFightRecorder::IsRecording())
+	{
+		const double Now = GetWorld()->GetTimeSeconds();
+		for (const FMeleeContact& Contact : EndedContacts)
+		{
+			if (Contact.Boss && Contact.Player)
+			{
+				FFightRecorder::Record(EFightRecordType::ContactEnd, Now, Contact.Boss->GetUniqueID(), Contact.Player->GetUniqueID());
+			}
+		}
+		for (const FMeleeContact& Contact : BeganContacts)
+		{
+			if (Contact.Boss && Contact.Player)
+			{
+				FFightRecorder::Record(EFightRecordType::ContactBegin, Now, Contact.Boss->GetUniqueID(), Contact.Player->GetUniqueID());
+			}
+		}
+	}
+
+	// The callbacks may unregister fighters, only call the ones still alive
+	for (const FMeleeContact& Contact : EndedContacts)
+	{
+		if (IsValid(Contact.Player))
+		{
+			Contact.Player->OnMeleeContactEnd(Contact.Boss);
+		}
+	}
+	for (const FMeleeContact& Contact : BeganContacts)
+	{
+		if (IsValid(Contact.Player) && IsValid(Contact.Boss))
+		{
+			Contact.Player->OnMeleeContactBegin(Contact.Boss);
+			Contact.Boss->OnMeleeContactBegin(Contact.Player);
+		}
+	}
+}
+
+void UMeleeReachSubsystem::IssueQueries()
+{
+	UWorld* World = GetWorld();
+	const FCollisionObjectQueryParams ObjectParams(ECC_Pawn);
+	for (int32 BossIndex = 0; BossIndex < Bosses.Num(); BossIndex++)
+	{
+		AAICharacter* Boss = Bosses[BossIndex];
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(MeleeReach), false, Boss);
+		PendingQueries[BossIndex] = World->AsyncOverlapByObjectType(Boss->GetActorLocation(), FQuat::Identity, ObjectParams,
+			FCollisionShape::MakeSphere(Boss->MeleeReach), QueryParams);
+	}
+}
+
+void UMeleeReachSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMeleeReachSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	if (Bosses.Num() == 0 && Contacts.Num() == 0)
+	{
+		return;
+	}
+
+	GatherContacts();
+	DispatchContactChanges();
+	IssueQueries();
+}
+
+TStatId UMeleeReachSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_MeleeReachTick);
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeReachSubsystem.generated.h"
+
+class AAICharacter;
+class ABossFightCharacter;
+
+/** A boss and a player within melee reach of each other */
+USTRUCT()
+struct FMeleeContact
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AAICharacter* Boss = nullptr;
+	UPROPERTY()
+	ABossFightCharacter* Player = nullptr;
+
+	bool operator==(const FMeleeContact& Other) const { return Boss == Other.Boss && Player == Other.Player; }
+	bool operator<(const FMeleeContact& Other) const
+	{
+		return Boss != Other.Boss ? (UPTRINT)Boss < (UPTRINT)Other.Boss : (UPTRINT)Player < (UPTRINT)Other.Player;
+	}
+};
+
+/**
+ * Melee contact between bosses and players for the whole world.
+ * Every frame each boss gets one asynchronous sphere overlap against pawns; the results are read on the next frame,
+ * merged into a single sorted contact table, and the contacts that began or ended are reported to both sides.
+ * Both fighters read the same table, so they always agree on who is in reach.
+ */
+UCLASS()
+class BOSSFIGHT_API UMeleeReachSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterBoss(AAICharacter* Boss);
+	void UnregisterBoss(AAICharacter* Boss);
+	/** Ends the contacts of a player leaving the fight, reported and recorded like contacts that ended */
+	void RemovePlayer(ABossFightCharacter* Player);
+
+	/** Returns a boss in reach of the player, nullptr if none */
+	AAICharacter* FindBossInReach(const ABossFightCharacter* Player) const;
+	/** Current contacts, sorted by boss */
+	FORCEINLINE const TArray<FMeleeContact>& GetContacts() const { return Contacts; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Reads the overlaps issued last frame into NewContacts */
+	void GatherContacts();
+	/** Reports the differences between Contacts and NewContacts, then makes NewContacts current */
+	void DispatchContactChanges();
+	void IssueQueries();
+
+	UPROPERTY()
+	TArray<AAICharacter*> Bosses;
+	/** Overlap of each boss issued last frame */
+	TArray<FTraceHandle> PendingQueries;
+
+	/** Current contacts, sorted */
+	UPROPERTY()
+	TArray<FMeleeContact> Contacts;
+	UPROPERTY()
+	TArray<FMeleeContact> NewContacts;
+
+	/** Scratch lists of the contacts that changed this frame, kept to avoid reallocating */
+	TArray<FMeleeContact> BeganContacts;
+	TArray<FMeleeContact> EndedContacts;
+};
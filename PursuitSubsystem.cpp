@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PursuitSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightStats.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+namespace
+{
+	/** Half height of the box a cell center is projected onto the navmesh with, around the height of the player */
+	constexpr float SampleHalfHeight = 250.f;
+}
+
+void UPursuitSubsystem::Deinitialize()
+{
+	Fields.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPursuitSubsystem::Pursue(AAICharacter* Boss, APawn* Player, float Duration)
+{
+	check(Boss);
+	if (!Player)
+	{
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Boss->PursuitIndex == INDEX_NONE)
+	{
+		Boss->PursuitIndex = Pursuers.Add(Boss);
+		PursuedPlayers.Add(Player);
+		PursuitStopTimes.Add(Now + Duration);
+	}
+	else
+	{
+		PursuedPlayers[Boss->PursuitIndex] = Player;
+		PursuitStopTimes[Boss->PursuitIndex] = Now + Duration;
+	}
+
+	int32 FieldIndex = FindField(Player);
+	if (FieldIndex == INDEX_NONE)
+	{
+		FieldIndex = Fields.AddDefaulted();
+		Fields[FieldIndex].Player = Player;
+		Fields[FieldIndex].Field = MakeUnique<FPursuitField>();
+	}
+	Fields[FieldIndex].LastPursuitTime = Now;
+}
+
+bool UPursuitSubsystem::ExtendPursuit(AAICharacter* Boss, float Duration)
+{
+	if (Boss->PursuitIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	PursuitStopTimes[Boss->PursuitIndex] = GetWorld()->GetTimeSeconds() + Duration;
+	return true;
+}
+
+void UPursuitSubsystem::StopPursuit(AAICharacter* Boss)
+{
+	const int32 PursuitIndex = Boss->PursuitIndex;
+	if (PursuitIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	Pursuers.RemoveAtSwap(PursuitIndex, 1, false);
+	PursuedPlayers.RemoveAtSwap(PursuitIndex, 1, false);
+	PursuitStopTimes.RemoveAtSwap(PursuitIndex, 1, false);
+	if (Pursuers.IsValidIndex(PursuitIndex))
+	{
+		Pursuers[PursuitIndex]->PursuitIndex = PursuitIndex;
+	}
+	Boss->PursuitIndex = INDEX_NONE;
+}
+
+int32 UPursuitSubsystem::FindField(const APawn* Player) const
+{
+	// A handful of players at most, a linear search beats hashing
+	for (int32 FieldIndex = 0; FieldIndex < Fields.Num(); FieldIndex++)
+	{
+		if (Fields[FieldIndex].Player.Get() == Player)
+		{
+			return FieldIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void UPursuitSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UPursuitSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 PursuitIndex = Pursuers.Num() - 1; PursuitIndex >= 0; PursuitIndex--)
+	{
+		if (Now >= PursuitStopTimes[PursuitIndex] || !PursuedPlayers[PursuitIndex].IsValid())
+		{
+			StopPursuit(Pursuers[PursuitIndex]);
+		}
+	}
+
+	UpdateFields(Now, MaxCellsPerFrame, MaxSamplesPerFrame);
+	SteerPursuers();
+	FBossFightStats::SetPursuitCounts(Fields.Num(), Pursuers.Num());
+}
+
+void UPursuitSubsystem::UpdateFields(double Now, int32 CellBudget, int32 SampleBudget)
+{
+	for (int32 FieldIndex = Fields.Num() - 1; FieldIndex >= 0; FieldIndex--)
+	{
+		const FPlayerField& PlayerField = Fields[FieldIndex];
+		if (!PlayerField.Player.IsValid() || Now > PlayerField.LastPursuitTime + FieldLifetime)
+		{
+			Fields.RemoveAtSwap(FieldIndex, 1, false);
+		}
+	}
+	if (Fields.Num() == 0)
+	{
+		return;
+	}
+
+	// A navmesh still being built would leave holes in a field until it is sampled again, new samplings wait for it
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	const bool bCanBeginSample = NavData && !NavSys->IsNavigationBuildInProgress();
+
+	NextBuildField = (NextBuildField + 1) % Fields.Num();
+	for (int32 Offset = 0; Offset < Fields.Num(); Offset++)
+	{
+		FPlayerField& PlayerField = Fields[(NextBuildField + Offset) % Fields.Num()];
+		FPursuitField& Field = *PlayerField.Field;
+		const FIntPoint PlayerCell = GetCell(PlayerField, PlayerField.Player->GetActorLocation());
+
+		const int32 CenterDistance = FMath::Max(FMath::Abs(PlayerCell.X - FPursuitField::Size / 2), FMath::Abs(PlayerCell.Y - FPursuitField::Size / 2));
+		if (bCanBeginSample && !PlayerField.bSampling && (!PlayerField.bSampled || CenterDistance > RecenterDistance))
+		{
+			BeginSample(PlayerField);
+		}
+		if (NavData && PlayerField.bSampling && SampleBudget > 0)
+		{
+			ContinueSample(PlayerField, *NavData, SampleBudget);
+		}
+
+		// The sampling may just have moved the field
+		const FIntPoint Goal = GetCell(PlayerField, PlayerField.Player->GetActorLocation());
+		if (!PlayerField.bSampled || !FPursuitField::IsInside(Goal.X, Goal.Y))
+		{
+			continue;
+		}
+
+		// A build runs to its end before the next one starts, or a running player would starve the field
+		if (!Field.IsBuilding() && (!Field.IsReadable() || Goal.X != Field.GetGoalX() || Goal.Y != Field.GetGoalY()))
+		{
+			Field.BeginBuild(Goal.X, Goal.Y, MaxStepHeight);
+		}
+		Field.ContinueBuild(CellBudget);
+	}
+}
+
+void UPursuitSubsystem::SteerPursuers()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 PursuitIndex = 0; PursuitIndex < Pursuers.Num(); PursuitIndex++)
+	{
+		AAICharacter* Boss = Pursuers[PursuitIndex];
+		const APawn* Player = PursuedPlayers[PursuitIndex].Get();
+		const FVector BossLocation = Boss->GetActorLocation();
+
+		// Outside of the field, on the goal cell or cut off from it the boss heads straight at the player
+		FVector Target = Player->GetActorLocation();
+		const int32 FieldIndex = FindField(Player);
+		if (FieldIndex != INDEX_NONE)
+		{
+			FPlayerField& PlayerField = Fields[FieldIndex];
+			PlayerField.LastPursuitTime = Now;
+			const FIntPoint Cell = GetCell(PlayerField, BossLocation);
+			const uint8 Direction = PlayerField.Field->GetDirection(Cell.X, Cell.Y);
+			if (Direction != FPursuitField::NoDirection)
+			{
+				const FIntPoint Next(Cell.X + FPursuitField::GetStepX(Direction), Cell.Y + FPursuitField::GetStepY(Direction));
+				Target = PlayerField.Origin + FVector((Next.X + 0.5f) * CellSize, (Next.Y + 0.5f) * CellSize, 0.f);
+			}
+		}
+		Boss->AddMovementInput((Target - BossLocation).GetSafeNormal2D());
+	}
+}
+
+void UPursuitSubsystem::BeginSample(FPlayerField& PlayerField)
+{
+	// Snapped to whole cells, so the cells of the old and the new field line up
+	const FVector PlayerLocation = PlayerField.Player->GetActorLocation();
+	const float HalfExtent = FPursuitField::Size * CellSize * 0.5f;
+	PlayerField.SampleOrigin = FVector(FMath::GridSnap(PlayerLocation.X - HalfExtent, CellSize), FMath::GridSnap(PlayerLocation.Y - HalfExtent, CellSize), PlayerLocation.Z);
+	PlayerField.SampleWalkable.SetNumUninitialized(FPursuitField::NumCells);
+	PlayerField.SampleHeights.SetNumUninitialized(FPursuitField::NumCells);
+	PlayerField.NumSampledCells = 0;
+	PlayerField.bSampling = true;
+}
+
+void UPursuitSubsystem::ContinueSample(FPlayerField& PlayerField, const ANavigationData& NavData, int32& SampleBudget)
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_PursuitSample);
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, SampleHalfHeight);
+	FNavLocation NavLocation;
+
+	const int32 FirstCell = PlayerField.NumSampledCells;
+	const int32 EndCell = FMath::Min(FirstCell + SampleBudget, FPursuitField::NumCells);
+	for (int32 Cell = FirstCell; Cell < EndCell; Cell++)
+	{
+		const int32 X = Cell % FPursuitField::Size;
+		const int32 Y = Cell / FPursuitField::Size;
+		const FVector Center = PlayerField.SampleOrigin + FVector((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize, 0.f);
+		const bool bOnNavmesh = NavData.ProjectPoint(Center, NavLocation, Extent);
+		PlayerField.SampleWalkable[Cell] = (uint8)bOnNavmesh;
+		PlayerField.SampleHeights[Cell] = bOnNavmesh ? (float)NavLocation.Location.Z : (float)PlayerField.SampleOrigin.Z;
+	}
+	SampleBudget -= EndCell - FirstCell;
+	PlayerField.NumSampledCells = EndCell;
+	FBossFightStats::AddNavQueries(EndCell - FirstCell);
+	if (EndCell < FPursuitField::NumCells)
+	{
+		return;
+	}
+
+	// The old directions do not match the new cells, pursuers head straight at the player until the next build is done
+	FPursuitField& Field = *PlayerField.Field;
+	Field.Reset();
+	for (int32 Y = 0; Y < FPursuitField::Size; Y++)
+	{
+		for (int32 X = 0; X < FPursuitField::Size; X++)
+		{
+			const int32 Cell = Y * FPursuitField::Size + X;
+			Field.SetCell(X, Y, PlayerField.SampleWalkable[Cell] != 0, PlayerField.SampleHeights[Cell]);
+		}
+	}
+	PlayerField.Origin = PlayerField.SampleOrigin;
+	PlayerField.bSampled = true;
+	PlayerField.bSampling = false;
+}
+
+TStatId UPursuitSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_PursuitTick);
+}
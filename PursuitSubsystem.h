@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlowField.h"
+#include "PursuitSubsystem.generated.h"
+
+class AAICharacter;
+class ANavigationData;
+
+/**
+ * Steers the bosses chasing a player along one flow field per player instead of one path per boss.
+ * The field covers FieldSize x FieldSize cells of CellSize around the player. Its walkable cells are sampled from the
+ * navmesh whenever the player strays too far from its center, and its distances are rebuilt whenever the player changes
+ * cell, both under per-frame cell budgets on the game thread, where the navmesh is never rebuilt under a query. Every frame each pursuing boss reads the next step from
+ * the cell it stands in and gets it as movement input, so pursuit costs grow with the players, not the bosses.
+ * Server only, like the bosses' thinking.
+ */
+UCLASS()
+class BOSSFIGHT_API UPursuitSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	typedef TFlowField<96> FPursuitField;
+
+	/** Edge length of a field cell */
+	static constexpr float CellSize = 150.f;
+	/** The field is sampled again around the player once it is this many cells from the center */
+	static constexpr int32 RecenterDistance = FPursuitField::Size / 4;
+	/** Height difference between neighbor cells a boss can still walk */
+	static constexpr float MaxStepHeight = 60.f;
+	/** Field cells expanded per frame, for all fields together */
+	static constexpr int32 MaxCellsPerFrame = 4096;
+	/** Field cells projected onto the navmesh per frame, for all fields together */
+	static constexpr int32 MaxSamplesPerFrame = 1024;
+	/** Seconds a field is kept after its last pursuer stopped */
+	static constexpr float FieldLifetime = 10.f;
+
+	virtual void Deinitialize() override;
+
+	/** Makes the boss chase Player for Duration seconds, replacing what it chased before */
+	void Pursue(AAICharacter* Boss, APawn* Player, float Duration);
+	/** Pushes the end of the pursuit of the boss to Duration seconds from now, returns false if it pursues nobody */
+	bool ExtendPursuit(AAICharacter* Boss, float Duration);
+	/** Stops the pursuit of the boss, if any */
+	void StopPursuit(AAICharacter* Boss);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	struct FPlayerField
+	{
+		TWeakObjectPtr<APawn> Player;
+		/** Heap allocated, a field is a few hundred kilobytes */
+		TUniquePtr<FPursuitField> Field;
+		/** World location of the corner of cell 0, 0 */
+		FVector Origin = FVector::ZeroVector;
+		bool bSampled = false;
+		double LastPursuitTime = 0.0;
+
+		/** Sampling of the next field, the current one is read until it is done */
+		bool bSampling = false;
+		int32 NumSampledCells = 0;
+		FVector SampleOrigin = FVector::ZeroVector;
+		TArray<uint8> SampleWalkable;
+		TArray<float> SampleHeights;
+	};
+
+	int32 FindField(const APawn* Player) const;
+	/** Recenters, rebuilds and frees the fields, spends at most CellBudget cells on builds and SampleBudget on samples */
+	void UpdateFields(double Now, int32 CellBudget, int32 SampleBudget);
+	/** Starts sampling a field centered on the player */
+	void BeginSample(FPlayerField& PlayerField);
+	/** Projects the next cells of the sampling onto the navmesh, replaces the field once every cell is in */
+	void ContinueSample(FPlayerField& PlayerField, const ANavigationData& NavData, int32& SampleBudget);
+	/** Gives every pursuing boss its step for this frame */
+	void SteerPursuers();
+
+	/** Cell of a location in a field, may be outside of it */
+	static FORCEINLINE FIntPoint GetCell(const FPlayerField& PlayerField, const FVector& Location)
+	{
+		return FIntPoint(FMath::FloorToInt((Location.X - PlayerField.Origin.X) / CellSize), FMath::FloorToInt((Location.Y - PlayerField.Origin.Y) / CellSize));
+	}
+
+	TArray<FPlayerField> Fields;
+	/** Field the next build budget starts with, so every field gets its turn */
+	int32 NextBuildField = 0;
+
+	/** Per pursuer state, indexed by the PursuitIndex of the boss */
+	UPROPERTY()
+	TArray<AAICharacter*> Pursuers;
+	TArray<TWeakObjectPtr<APawn>> PursuedPlayers;
+	TArray<double> PursuitStopTimes;
+};
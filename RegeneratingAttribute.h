@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include <limits>
+
+/**
+ * A resource that refills at a constant rate up to a cap, stored as "value at timestamp + rate + cap".
+ * The current value is computed on read, so regeneration costs nothing while nobody looks at it.
+ */
+struct FRegeneratingAttribute
+{
+	static constexpr double NeverFull = std::numeric_limits<double>::max();
+
+	FRegeneratingAttribute()
+		: BaseValue(0.f)
+		, BaseTime(0.0)
+		, MaxValue(0.f)
+		, RegenRate(0.f)
+	{
+	}
+
+	FRegeneratingAttribute(float InValue, float InMaxValue, float InRegenRate, double Now)
+		: BaseValue(InValue)
+		, BaseTime(Now)
+		, MaxValue(InMaxValue)
+		, RegenRate(InRegenRate)
+	{
+	}
+
+	/** Returns the value at the given time */
+	FORCEINLINE float Get(double Now) const
+	{
+		if (BaseValue >= MaxValue)
+		{
+			return MaxValue;
+		}
+		const double Value = BaseValue + RegenRate * (Now - BaseTime);
+		return Value < MaxValue ? (float)Value : MaxValue;
+	}
+
+	/** Overwrites the value, regeneration continues from here */
+	FORCEINLINE void Set(float NewValue, double Now)
+	{
+		BaseValue = NewValue;
+		BaseTime = Now;
+	}
+
+	/** Adds Delta (negative to spend) to the value at the given time */
+	FORCEINLINE void Add(float Delta, double Now)
+	{
+		Set(Get(Now) + Delta, Now);
+	}
+
+	FORCEINLINE bool IsFull(double Now) const
+	{
+		return Get(Now) >= MaxValue;
+	}
+
+	/** Returns the time at which the value reaches the cap, Now if it already has and NeverFull if it never will */
+	FORCEINLINE double GetFullTime(double Now) const
+	{
+		const float Current = Get(Now);
+		if (Current >= MaxValue)
+		{
+			return Now;
+		}
+		if (RegenRate <= 0.f)
+		{
+			return NeverFull;
+		}
+		return Now + (MaxValue - Current) / RegenRate;
+	}
+
+	/** Value and time regeneration is computed from, enough to rebuild the attribute elsewhere */
+	FORCEINLINE float GetBaseValue() const { return BaseValue; }
+	FORCEINLINE double GetBaseTime() const { return BaseTime; }
+	FORCEINLINE float GetMaxValue() const { return MaxValue; }
+	FORCEINLINE float GetRegenRate() const { return RegenRate; }
+
+private:
+	float BaseValue;
+	double BaseTime;
+	float MaxValue;
+	/** Units per second */
+	float RegenRate;
+};
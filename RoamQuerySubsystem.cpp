@@ -0,0 +1,217 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RoamQuerySubsystem.h"
+#include "Async/Async.h"
+#include "BossBrainSubsystem.h"
+#include "BossFightStats.h"
+#include "Engine/World.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "UObject/UObjectGlobals.h"
+
+void URoamQuerySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &URoamQuerySubsystem::WaitForBatch);
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &URoamQuerySubsystem::OnWorldTickStart);
+
+	// Its own stream of the boss seed, BossFight.Seed replays the pool picks too
+	Random = FCombatRandom::ForStream(Collection.InitializeDependency<UBossBrainSubsystem>()->GetSeed(), MAX_uint32 - 1);
+}
+
+void URoamQuerySubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	WaitForBatch();
+	InFlightBatch.Reset();
+	QueuedRequests.Reset();
+	Pools.Reset();
+
+	Super::Deinitialize();
+}
+
+void URoamQuerySubsystem::RequestRoamPoint(const FVector& Origin, float Radius, FRoamQueryDelegate Callback)
+{
+	QueuedRequests.Add({ Origin, Radius, MoveTemp(Callback) });
+}
+
+FIntVector URoamQuerySubsystem::GetRegion(const FVector& Location)
+{
+	return FIntVector(FMath::FloorToInt(Location.X / RegionSize), FMath::FloorToInt(Location.Y / RegionSize), 0);
+}
+
+bool URoamQuerySubsystem::TryServeFromPool(const FRoamRequest& Request)
+{
+	const FRoamPointPool* Pool = Pools.Find(GetRegion(Request.Origin));
+	if (!Pool || Pool->Points.Num() == 0)
+	{
+		return false;
+	}
+
+	// A few random picks are enough, a pool point outside the radius only happens near region borders
+	const float RadiusSquared = FMath::Square(Request.Radius);
+	for (int32 Attempt = 0; Attempt < 4; Attempt++)
+	{
+		const FVector& Point = Pool->Points[Random.RandRange(0, Pool->Points.Num() - 1)];
+		if (FVector::DistSquared2D(Point, Request.Origin) <= RadiusSquared)
+		{
+			NumCacheHits++;
+			Request.Callback.ExecuteIfBound(true, Point);
+			return true;
+		}
+	}
+	return false;
+}
+
+void URoamQuerySubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URoamQuerySubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	if (QueuedRequests.Num() == 0)
+	{
+		return;
+	}
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	TArray<FRoamRequest> Requests = MoveTemp(QueuedRequests);
+	if (!NavData)
+	{
+		for (const FRoamRequest& Request : Requests)
+		{
+			Request.Callback.ExecuteIfBound(false, Request.Origin);
+		}
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const bool bCanDispatch = !InFlightBatch && !NavSys->IsNavigationBuildInProgress();
+	TSharedRef<FRoamBatch> Batch = MakeShared<FRoamBatch>();
+
+	for (FRoamRequest& Request : Requests)
+	{
+		const FIntVector Region = GetRegion(Request.Origin);
+		FRoamPointPool& Pool = Pools.FindOrAdd(Region);
+		if (Pool.Points.Num() == 0 && !Pool.bRefreshInFlight)
+		{
+			Pool.SeedLocation = Request.Origin;
+		}
+
+		const bool bStale = Pool.Points.Num() == 0 || Now >= Pool.RefreshTime + PoolRefreshInterval;
+		if (bStale && bCanDispatch && !Pool.bRefreshInFlight)
+		{
+			Pool.bRefreshInFlight = true;
+			Batch->Regions.Add(Region);
+			Batch->RegionSeeds.Add(Pool.SeedLocation);
+		}
+
+		if (TryServeFromPool(Request))
+		{
+			continue;
+		}
+		if (bCanDispatch)
+		{
+			Batch->Requests.Add(MoveTemp(Request));
+		}
+		else
+		{
+			QueuedRequests.Add(MoveTemp(Request));
+		}
+	}
+
+	if (Batch->Requests.Num() == 0 && Batch->Regions.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 BatchNavQueries = Batch->Requests.Num() + Batch->Regions.Num() * PointsPerRegion;
+	NumNavQueries += BatchNavQueries;
+	FBossFightStats::AddNavQueries(BatchNavQueries);
+	Batch->NavData = NavData;
+	InFlightBatch = Batch;
+
+	// Tickable subsystems tick after the tick groups, the batch overlaps the end of the frame and is done when the
+	// next world tick starts, before the navigation system attaches rebuilt tiles
+	BatchFuture = Async(EAsyncExecution::ThreadPool, [Batch]()
+	{
+		Batch->Execute();
+	});
+}
+
+void URoamQuerySubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || !InFlightBatch)
+	{
+		return;
+	}
+
+	WaitForBatch();
+	const TSharedPtr<FRoamBatch> Batch = MoveTemp(InFlightBatch);
+	OnBatchCompleted(*Batch);
+}
+
+void URoamQuerySubsystem::FRoamBatch::Execute()
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_RoamQueryBatch);
+	FNavLocation NavLocation;
+
+	RequestResults.SetNumUninitialized(Requests.Num());
+	RequestSuccess.SetNumUninitialized(Requests.Num());
+	for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); RequestIndex++)
+	{
+		const FRoamRequest& Request = Requests[RequestIndex];
+		RequestSuccess[RequestIndex] = NavData->GetRandomReachablePointInRadius(Request.Origin, Request.Radius, NavLocation);
+		RequestResults[RequestIndex] = RequestSuccess[RequestIndex] ? NavLocation.Location : Request.Origin;
+	}
+
+	RegionPoints.SetNum(Regions.Num());
+	for (int32 RegionIndex = 0; RegionIndex < Regions.Num(); RegionIndex++)
+	{
+		TArray<FVector>& Points = RegionPoints[RegionIndex];
+		Points.Reserve(PointsPerRegion);
+		for (int32 PointIndex = 0; PointIndex < PointsPerRegion; PointIndex++)
+		{
+			if (NavData->GetRandomReachablePointInRadius(RegionSeeds[RegionIndex], RegionSize, NavLocation))
+			{
+				Points.Add(NavLocation.Location);
+			}
+		}
+	}
+}
+
+void URoamQuerySubsystem::OnBatchCompleted(FRoamBatch& Batch)
+{
+	BOSSFIGHT_SCOPE_CYCLE_COUNTER(STAT_BossFight_RoamQueryCompleted);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 RegionIndex = 0; RegionIndex < Batch.Regions.Num(); RegionIndex++)
+	{
+		if (FRoamPointPool* Pool = Pools.Find(Batch.Regions[RegionIndex]))
+		{
+			Pool->Points = MoveTemp(Batch.RegionPoints[RegionIndex]);
+			Pool->RefreshTime = Now;
+			Pool->bRefreshInFlight = false;
+		}
+	}
+
+	for (int32 RequestIndex = 0; RequestIndex < Batch.Requests.Num(); RequestIndex++)
+	{
+		Batch.Requests[RequestIndex].Callback.ExecuteIfBound(Batch.RequestSuccess[RequestIndex], Batch.RequestResults[RequestIndex]);
+	}
+}
+
+void URoamQuerySubsystem::WaitForBatch()
+{
+	if (BatchFuture.IsValid())
+	{
+		BatchFuture.Wait();
+	}
+}
+
+TStatId URoamQuerySubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_RoamQueryTick);
+}
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRules.h"
+#include "RoamQuerySubsystem.generated.h"
+
+class ANavigationData;
+
+/** Called on the game thread with the roam target, bSuccess is false if none was found */
+DECLARE_DELEGATE_TwoParams(FRoamQueryDelegate, bool /*bSuccess*/, const FVector& /*Location*/);
+
+/**
+ * Hands out random reachable roam targets.
+ * Requests are queued and resolved once per frame. Most of them are served from a pool of reachable
+ * points kept per navmesh region; misses and pool refreshes run as one batch off the game thread.
+ * The navigation system attaches rebuilt navmesh tiles during the world tick, so a batch dispatched at the end of a
+ * frame is waited for and completed when the next world tick starts: it never runs while tiles change, and its
+ * results arrive on a fixed frame. Pool hits roll from a stream of the boss seed, like every other boss roll.
+ */
+UCLASS()
+class BOSSFIGHT_API URoamQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Edge length of a pool region */
+	static constexpr float RegionSize = 10000.f;
+	/** Points kept per region */
+	static constexpr int32 PointsPerRegion = 32;
+	/** Seconds before a region pool is sampled again, so navmesh changes are picked up */
+	static constexpr float PoolRefreshInterval = 30.f;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Queues a request for a random reachable point within Radius of Origin */
+	void RequestRoamPoint(const FVector& Origin, float Radius, FRoamQueryDelegate Callback);
+
+	/** Queries sent to the navigation system since the start of the world */
+	FORCEINLINE int32 GetNumNavQueries() const { return NumNavQueries; }
+	FORCEINLINE int32 GetNumCacheHits() const { return NumCacheHits; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	struct FRoamRequest
+	{
+		FVector Origin;
+		float Radius;
+		FRoamQueryDelegate Callback;
+	};
+
+	struct FRoamPointPool
+	{
+		TArray<FVector> Points;
+		/** On-navmesh location the pool is sampled around */
+		FVector SeedLocation = FVector::ZeroVector;
+		double RefreshTime = 0.0;
+		bool bRefreshInFlight = false;
+	};
+
+	/** Work and results of one asynchronous batch */
+	struct FRoamBatch
+	{
+		const ANavigationData* NavData = nullptr;
+		TArray<FRoamRequest> Requests;
+		TArray<FVector> RequestResults;
+		TArray<bool> RequestSuccess;
+		TArray<FIntVector> Regions;
+		TArray<FVector> RegionSeeds;
+		TArray<TArray<FVector>> RegionPoints;
+
+		/** Runs on a worker thread */
+		void Execute();
+	};
+
+	/** Pools are keyed by 2D cell, Z is always 0 */
+	static FIntVector GetRegion(const FVector& Location);
+
+	/** Tries to answer a request from the pool of its region */
+	bool TryServeFromPool(const FRoamRequest& Request);
+	void OnBatchCompleted(FRoamBatch& Batch);
+	/** Finishes the in-flight batch before the navigation system ticks */
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	/** Blocks until the in-flight batch stopped touching the navmesh, called before GC and on shutdown */
+	void WaitForBatch();
+
+	TArray<FRoamRequest> QueuedRequests;
+	TMap<FIntVector, FRoamPointPool> Pools;
+	TSharedPtr<FRoamBatch> InFlightBatch;
+	TFuture<void> BatchFuture;
+	FDelegateHandle PreGarbageCollectHandle;
+	FDelegateHandle WorldTickStartHandle;
+	FCombatRandom Random;
+
+	int32 NumNavQueries = 0;
+	int32 NumCacheHits = 0;
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "CooldownTracker.h"
+
+/** Ids of the built-in skills, an id is the index of the skill in its table */
+enum class ESkillId : uint8
+{
+	FirstSkill,
+	SecondSkill,
+	ThirdSkill,
+	BasicAttack,
+};
+
+/** Runtime description of a skill. Plain data so a table of them stays one flat array. */
+struct FSkillDefinition
+{
+	/** Ability points spent on use */
+	float Cost;
+	float Damage;
+	/** Cooldown in seconds, 0 for none */
+	float Cooldown;
+	/** Seconds between activation and the fighter being able to act again (player) or the hit landing (boss) */
+	float WindUp;
+	/** Slot of the cooldown tracker used by this skill */
+	uint8 CooldownSlot;
+};
+
+/** Default player skills */
+constexpr FSkillDefinition GPlayerDefaultSkills[] =
+{
+	{ 20.f, 20.f, 6.f,  1.2f, (uint8)ECooldownSlot::FirstSkill },
+	{ 30.f, 30.f, 8.f,  1.4f, (uint8)ECooldownSlot::SecondSkill },
+	{ 40.f, 40.f, 10.f, 1.6f, (uint8)ECooldownSlot::ThirdSkill },
+	{ 0.f,  10.f, 0.f,  1.0f, 0 },
+};
+
+/** Default boss skills */
+constexpr FSkillDefinition GBossDefaultSkills[] =
+{
+	{ 20.f, 10.f, 4.f, 1.2f, (uint8)ECooldownSlot::FirstSkill },
+	{ 30.f, 20.f, 6.f, 1.4f, (uint8)ECooldownSlot::SecondSkill },
+	{ 40.f, 30.f, 8.f, 1.6f, (uint8)ECooldownSlot::ThirdSkill },
+	{ 0.f,  5.f,  0.f, 1.0f, 0 },
+};
+
+/** Skill table indexed by skill id, stored inline as one flat array */
+struct FSkillTable
+{
+	static constexpr int32 MaxSkills = 16;
+
+	template<int32 N>
+	void Assign(const FSkillDefinition (&Definitions)[N])
+	{
+		static_assert(N <= MaxSkills, "Too many skills");
+		Reset();
+		for (int32 SkillId = 0; SkillId < N; SkillId++)
+		{
+			Add(Definitions[SkillId]);
+		}
+		FallbackSkill = (int32)ESkillId::BasicAttack < N ? (int32)ESkillId::BasicAttack : N - 1;
+	}
+
+	void Reset()
+	{
+		NumSkills = 0;
+		FallbackSkill = INDEX_NONE;
+	}
+
+	/** Appends a skill, returns false when the table is full */
+	bool Add(const FSkillDefinition& Skill)
+	{
+		if (NumSkills >= MaxSkills)
+		{
+			return false;
+		}
+		Skills[NumSkills++] = Skill;
+		return true;
+	}
+
+	FORCEINLINE int32 Num() const { return NumSkills; }
+	FORCEINLINE bool IsValidSkill(int32 SkillId) const { return SkillId >= 0 && SkillId < NumSkills; }
+	FORCEINLINE const FSkillDefinition& operator[](int32 SkillId) const { check(IsValidSkill(SkillId)); return Skills[SkillId]; }
+	FORCEINLINE FSkillDefinition& operator[](int32 SkillId) { check(IsValidSkill(SkillId)); return Skills[SkillId]; }
+
+	/** Skill used when the chosen one cannot be afforded, usually the basic attack */
+	int32 FallbackSkill = INDEX_NONE;
+
+private:
+	FSkillDefinition Skills[MaxSkills];
+	int32 NumSkills = 0;
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "SkillDefinition.h"
+
+/**
+ * Runs any skill of a skill table for any fighter type.
+ * FighterType must provide:
+ *	float GetSkillResource() const;
+ *	void SpendSkillResource(float Amount);
+ *	void ApplySkillDamage(float Damage);
+ *	FCooldownTracker& GetCooldowns(); and its const overload
+ */
+template<typename FighterType>
+struct TSkillExecutor
+{
+	/** Returns true if the fighter can afford the skill and its cooldown has run out */
+	static bool CanActivate(const FighterType& Fighter, const FSkillTable& Table, int32 SkillId, double Now)
+	{
+		if (!Table.IsValidSkill(SkillId))
+		{
+			return false;
+		}
+		const FSkillDefinition& Skill = Table[SkillId];
+		return Fighter.GetSkillResource() >= Skill.Cost
+			&& (Skill.Cooldown <= 0.f || Fighter.GetCooldowns().IsReady(Skill.CooldownSlot, Now));
+	}
+
+	/**
+	 * Boss skill choice: Roll picks a skill of the table uniformly (0 to Num - 1),
+	 * the fallback skill is used instead when the rolled one cannot be activated.
+	 */
+	static int32 ChooseSkill(const FighterType& Fighter, const FSkillTable& Table, int32 Roll, double Now)
+	{
+		return CanActivate(Fighter, Table, Roll, Now) ? Roll : Table.FallbackSkill;
+	}
+
+	/** Pays the cost, deals the damage and starts the cooldown. Returns the wind-up of the skill. */
+	static float Execute(FighterType& Fighter, const FSkillDefinition& Skill, double Now)
+	{
+		if (Skill.Cost > 0.f)
+		{
+			Fighter.SpendSkillResource(Skill.Cost);
+		}
+		Fighter.ApplySkillDamage(Skill.Damage);
+		if (Skill.Cooldown > 0.f)
+		{
+			Fighter.GetCooldowns().Start(Skill.CooldownSlot, Now, Skill.Cooldown);
+		}
+		return Skill.WindUp;
+	}
+};
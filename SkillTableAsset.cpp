@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SkillTableAsset.h"
+
+void USkillTableAsset::BuildTable(FSkillTable& OutTable) const
+{
+	OutTable.Reset();
+	for (const FSkillDefinitionRow& Row : Skills)
+	{
+		FSkillDefinition Skill;
+		Skill.Cost = Row.Cost;
+		Skill.Damage = Row.Damage;
+		Skill.Cooldown = Row.Cooldown;
+		Skill.WindUp = Row.WindUp;
+		Skill.CooldownSlot = (uint8)FMath::Min<int32>(Row.CooldownSlot, FCooldownTracker::MaxSlots - 1);
+		if (!OutTable.Add(Skill))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s has more than %d skills, the extra rows are ignored"), *GetName(), FSkillTable::MaxSkills);
+			break;
+		}
+	}
+	OutTable.FallbackSkill = OutTable.IsValidSkill(FallbackSkill) ? FallbackSkill : OutTable.Num() - 1;
+}
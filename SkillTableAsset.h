@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SkillDefinition.h"
+#include "SkillTableAsset.generated.h"
+
+/** Editable row of a skill table asset */
+USTRUCT(BlueprintType)
+struct FSkillDefinitionRow
+{
+	GENERATED_BODY()
+
+	/** Input action that triggers the skill for the player, None for boss skills */
+	UPROPERTY(EditDefaultsOnly, Category = "Skill")
+	FName InputAction;
+	UPROPERTY(EditDefaultsOnly, Category = "Skill", meta = (ClampMin = "0"))
+	float Cost = 0.f;
+	UPROPERTY(EditDefaultsOnly, Category = "Skill")
+	float Damage = 0.f;
+	UPROPERTY(EditDefaultsOnly, Category = "Skill", meta = (ClampMin = "0"))
+	float Cooldown = 0.f;
+	UPROPERTY(EditDefaultsOnly, Category = "Skill", meta = (ClampMin = "0"))
+	float WindUp = 1.f;
+	UPROPERTY(EditDefaultsOnly, Category = "Skill", meta = (ClampMin = "0", ClampMax = "15"))
+	uint8 CooldownSlot = 0;
+};
+
+/** Skill table authored in the editor, the row index is the skill id */
+UCLASS(BlueprintType)
+class BOSSFIGHT_API USkillTableAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditDefaultsOnly, Category = "Skill")
+	TArray<FSkillDefinitionRow> Skills;
+
+	/** Row used when the chosen skill cannot be afforded */
+	UPROPERTY(EditDefaultsOnly, Category = "Skill")
+	int32 FallbackSkill = (int32)ESkillId::BasicAttack;
+
+	/** Fills the runtime table from the rows */
+	void BuildTable(FSkillTable& OutTable) const;
+};
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "StartupLoadSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightGameMode.h"
+#include "BossFightStats.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "GameMapsSettings.h"
+
+namespace
+{
+	/** Game mode the map will run, found without a game mode actor so clients can use it too */
+	const ABossFightGameMode* FindGameModeDefaults(const UWorld& World)
+	{
+		UClass* GameModeClass = nullptr;
+		if (const AWorldSettings* WorldSettings = World.GetWorldSettings())
+		{
+			GameModeClass = WorldSettings->DefaultGameMode;
+		}
+		if (!GameModeClass)
+		{
+			// Only resolves, a global default that is not loaded yet is left to InitGame on the server
+			GameModeClass = FSoftClassPath(UGameMapsSettings::GetGlobalDefaultGameMode()).ResolveClass();
+		}
+		return GameModeClass && GameModeClass->IsChildOf<ABossFightGameMode>() ? GameModeClass->GetDefaultObject<ABossFightGameMode>() : nullptr;
+	}
+}
+
+void UStartupLoadSubsystem::PostInitialize()
+{
+	Super::PostInitialize();
+
+	StartTime = FPlatformTime::Seconds();
+	LoadingGameMode = nullptr;
+	for (float& StageTime : StageTimes)
+	{
+		StageTime = -1.f;
+	}
+
+	if (const ABossFightGameMode* GameMode = FindGameModeDefaults(*GetWorld()))
+	{
+		BeginLoading(*GameMode);
+	}
+}
+
+void UStartupLoadSubsystem::Deinitialize()
+{
+	CancelLoads();
+	for (TArray<FSimpleDelegate>& Callbacks : PendingCallbacks)
+	{
+		Callbacks.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+bool UStartupLoadSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStartupLoadSubsystem::BeginLoading(const ABossFightGameMode& GameMode)
+{
+	if (LoadingGameMode == GameMode.GetClass())
+	{
+		return;
+	}
+	LoadingGameMode = GameMode.GetClass();
+	CancelLoads();
+
+	// Nobody can play without the pawn, it goes first
+	RequestStage(EStartupStage::PlayerPawn, { GameMode.PlayerPawnClass.ToSoftObjectPath() }, FStreamableManager::AsyncLoadHighPriority);
+
+	TArray<FSoftObjectPath> FighterPaths;
+	for (const TSoftClassPtr<AAICharacter>& BossClass : GameMode.BossClasses)
+	{
+		FighterPaths.AddUnique(BossClass.ToSoftObjectPath());
+	}
+	for (const FFighterPoolEntry& Entry : GameMode.PrewarmedFighters)
+	{
+		FighterPaths.AddUnique(Entry.Class.ToSoftObjectPath());
+	}
+	RequestStage(EStartupStage::Fighters, MoveTemp(FighterPaths), FStreamableManager::DefaultAsyncLoadPriority);
+}
+
+void UStartupLoadSubsystem::CallWhenDone(EStartupStage Stage, FSimpleDelegate Callback)
+{
+	if (IsDone(Stage))
+	{
+		Callback.ExecuteIfBound();
+	}
+	else
+	{
+		PendingCallbacks[(int32)Stage].Add(MoveTemp(Callback));
+	}
+}
+
+void UStartupLoadSubsystem::NotePlayable()
+{
+	if (!IsDone(EStartupStage::Playable))
+	{
+		FinishStage(EStartupStage::Playable);
+	}
+}
+
+void UStartupLoadSubsystem::RequestStage(EStartupStage Stage, TArray<FSoftObjectPath> Paths, TAsyncLoadPriority Priority)
+{
+	Paths.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull(); });
+	StageTimes[(int32)Stage] = -1.f;
+	if (Paths.Num() == 0)
+	{
+		FinishStage(Stage);
+		return;
+	}
+	// Classes bring the meshes, animation blueprints and skill tables they reference along
+	Handles[(int32)Stage] = UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(Paths),
+		FStreamableDelegate::CreateUObject(this, &UStartupLoadSubsystem::FinishStage, Stage), Priority);
+}
+
+void UStartupLoadSubsystem::FinishStage(EStartupStage Stage)
+{
+	const float StageTime = (float)(FPlatformTime::Seconds() - StartTime);
+	StageTimes[(int32)Stage] = StageTime;
+	FBossFightStats::SetStartupStageTime(Stage, StageTime);
+	UE_LOG(LogTemp, Log, TEXT("Startup stage %s done after %.0f ms"), *UEnum::GetValueAsString(Stage), StageTime * 1000.f);
+
+	// A callback may register another one
+	TArray<FSimpleDelegate> Callbacks = MoveTemp(PendingCallbacks[(int32)Stage]);
+	for (const FSimpleDelegate& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound();
+	}
+}
+
+void UStartupLoadSubsystem::CancelLoads()
+{
+	for (TSharedPtr<FStreamableHandle>& Handle : Handles)
+	{
+		if (Handle.IsValid() && Handle->IsLoadingInProgress())
+		{
+			Handle->CancelHandle();
+		}
+		Handle.Reset();
+	}
+}
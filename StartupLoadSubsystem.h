@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "StartupLoadSubsystem.generated.h"
+
+class ABossFightGameMode;
+
+UENUM(BlueprintType)
+enum class EStartupStage : uint8
+{
+	/** Class of the player pawn, players are only spawned once it is loaded */
+	PlayerPawn,
+	/** Boss and pooled fighter classes, with the meshes and animations they reference */
+	Fighters,
+	/** A player pawn was possessed: the first one on the server, the local one on clients */
+	Playable,
+	Count UMETA(Hidden)
+};
+
+/**
+ * Loads the fighter classes listed by the game mode through the asset manager while the map loads, on the server and
+ * on clients alike, so neither the player pawn nor the bosses are loaded on the game thread when they first spawn.
+ * Clients read the lists from the default game mode of the map. Every stage is timed from the start of the world.
+ */
+UCLASS()
+class BOSSFIGHT_API UStartupLoadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void PostInitialize() override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Starts loading the classes the game mode lists, does nothing if they are already loading.
+	 * The server calls it again from InitGame, its game mode may differ from the map default through ?game=.
+	 */
+	void BeginLoading(const ABossFightGameMode& GameMode);
+
+	/** Runs Callback once the stage is done, right away if it already is */
+	void CallWhenDone(EStartupStage Stage, FSimpleDelegate Callback);
+	FORCEINLINE bool IsDone(EStartupStage Stage) const { return StageTimes[(int32)Stage] >= 0.f; }
+
+	/** Called by the player pawn when it is possessed, only the first call counts */
+	void NotePlayable();
+
+	/** Seconds from the start of the world to the end of the stage, negative while it is running */
+	UFUNCTION(BlueprintPure, Category = "Startup")
+	float GetStageTime(EStartupStage Stage) const { return StageTimes[(int32)Stage]; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void RequestStage(EStartupStage Stage, TArray<FSoftObjectPath> Paths, TAsyncLoadPriority Priority);
+	void FinishStage(EStartupStage Stage);
+	void CancelLoads();
+
+	double StartTime = 0.0;
+	/** Game mode whose lists are loading */
+	UPROPERTY()
+	UClass* LoadingGameMode;
+
+	float StageTimes[(int32)EStartupStage::Count];
+	/** Keep the loaded classes referenced for the lifetime of the world */
+	TSharedPtr<FStreamableHandle> Handles[(int32)EStartupStage::Count];
+	TArray<FSimpleDelegate> PendingCallbacks[(int32)EStartupStage::Count];
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "StatusEffectSubsystem.h"
+#include "BossFightStats.h"
+#include "CombatDamageSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+FStatusEffectHandle UStatusEffectSubsystem::ApplyEffect(int32 TargetIndex, EStatusEffect Type, float Magnitude, float Duration, float Period, uint32 Source)
+{
+	if (TargetIndex < 0 || TargetIndex >= FEffectTable::TargetCapacity)
+	{
+		return FStatusEffectHandle();
+	}
+	if (!Table)
+	{
+		Table = MakeUnique<FEffectTable>();
+		Table->Reset(GetTick(GetWorld()->GetTimeSeconds()));
+		DamageQueue = GetWorld()->GetSubsystem<UCombatDamageSubsystem>();
+	}
+
+	const FStatusEffectSpec Spec = { Type, Magnitude, FMath::Max(ToTicks(Duration), 1u), Period > 0.f ? FMath::Max(ToTicks(Period), 1u) : 0u };
+	const FStatusEffectHandle Handle = Table->Apply(TargetIndex, Spec, Source);
+	if (!Handle.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Status effect table full, effect on target %d dropped"), TargetIndex);
+	}
+	else if (Type == EStatusEffect::MoveSpeed)
+	{
+		OnSpeedChanged(TargetIndex);
+	}
+	return Handle;
+}
+
+void UStatusEffectSubsystem::RemoveEffect(const FStatusEffectHandle& Handle)
+{
+	if (Table && Table->IsAlive(Handle))
+	{
+		const bool bSpeed = Table->GetType(Handle) == EStatusEffect::MoveSpeed;
+		const int32 TargetIndex = Table->GetTarget(Handle);
+		Table->Remove(Handle);
+		if (bSpeed)
+		{
+			OnSpeedChanged(TargetIndex);
+		}
+	}
+}
+
+void UStatusEffectSubsystem::RemoveTarget(int32 TargetIndex)
+{
+	if (Table && TargetIndex >= 0 && TargetIndex < FEffectTable::TargetCapacity && Table->RemoveTarget(TargetIndex))
+	{
+		OnSpeedChanged(TargetIndex);
+	}
+}
+
+float UStatusEffectSubsystem::GetBaseWalkSpeed(const ACharacter& Character)
+{
+	// The class default keeps what the blueprint set, whatever effects did to the instance
+	const ACharacter* Defaults = Character.GetClass()->GetDefaultObject<ACharacter>();
+	return Defaults->GetCharacterMovement()->MaxWalkSpeed;
+}
+
+void UStatusEffectSubsystem::OnEffectTick(int32 TargetIndex, EStatusEffect Type, float Magnitude, uint32 Source)
+{
+	if (Type == EStatusEffect::DamageOverTime)
+	{
+		DamageQueue->QueueDamage(TargetIndex, Magnitude, Source);
+	}
+	else if (Type == EStatusEffect::HealOverTime)
+	{
+		DamageQueue->Heal(TargetIndex, Magnitude);
+	}
+}
+
+void UStatusEffectSubsystem::OnSpeedChanged(int32 TargetIndex)
+{
+	if (ACharacter* Character = Cast<ACharacter>(DamageQueue->GetOwner(TargetIndex)))
+	{
+		Character->GetCharacterMovement()->MaxWalkSpeed = GetBaseWalkSpeed(*Character) * Table->GetSpeedScale(TargetIndex);
+	}
+}
+
+uint32 UStatusEffectSubsystem::GetTick(double Time) const
+{
+	return (uint32)FMath::FloorToInt64(Time * TickRate);
+}
+
+uint32 UStatusEffectSubsystem::ToTicks(float Seconds)
+{
+	return (uint32)FMath::RoundToInt(Seconds * TickRate);
+}
+
+void UStatusEffectSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UStatusEffectSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	if (!Table)
+	{
+		return;
+	}
+	Table->Advance(GetTick(GetWorld()->GetTimeSeconds()), *this);
+	FBossFightStats::SetStatusEffects(Table->Num());
+}
+
+TStatId UStatusEffectSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_StatusEffectTick);
+}
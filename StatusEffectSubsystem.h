@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StatusEffects.h"
+#include "StatusEffectSubsystem.generated.h"
+
+class ACharacter;
+class UCombatDamageSubsystem;
+
+/**
+ * Buffs and debuffs of every fighter of the world: damage and healing over time and walk speed changes.
+ * Effects live in one TStatusEffectTable driven by a hierarchical timing wheel at TickRate, so tens of thousands of
+ * effects cost no timers and no heap operations; the clock is advanced to the world time once per frame. Fighters
+ * are keyed by their index in UCombatDamageSubsystem, damage goes through its queue and healing is applied at once.
+ * The walk speed of a fighter is its class default times its MoveSpeed effects.
+ * Server only, like the bosses' thinking.
+ */
+UCLASS()
+class BOSSFIGHT_API UStatusEffectSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	typedef TStatusEffectTable<65536, 16384> FEffectTable;
+
+	/** Ticks per second of the effect clock, durations and periods are rounded to it */
+	static constexpr float TickRate = 20.f;
+
+	/**
+	 * Starts an effect on a fighter, or refreshes the one of the same type from the same source.
+	 * @param TargetIndex	Index of the fighter in UCombatDamageSubsystem
+	 * @param Period		Seconds between two ticks of damage or healing, 0 for MoveSpeed
+	 * @param Source		Unique id of whoever applied it
+	 */
+	FStatusEffectHandle ApplyEffect(int32 TargetIndex, EStatusEffect Type, float Magnitude, float Duration, float Period, uint32 Source);
+	/** Ends an effect early, does nothing if it already ended */
+	void RemoveEffect(const FStatusEffectHandle& Handle);
+	/** Ends every effect of a fighter, for fighters leaving the fight; the walk speed goes back to the default */
+	void RemoveTarget(int32 TargetIndex);
+
+	/** Walk speed of the class of a character, before any effect */
+	static float GetBaseWalkSpeed(const ACharacter& Character);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Called back by the table while it advances */
+	void OnEffectTick(int32 TargetIndex, EStatusEffect Type, float Magnitude, uint32 Source);
+	void OnSpeedChanged(int32 TargetIndex);
+
+private:
+	uint32 GetTick(double Time) const;
+	static uint32 ToTicks(float Seconds);
+
+	/** Heap allocated on the first effect, the table is a few megabytes */
+	TUniquePtr<FEffectTable> Table;
+	UPROPERTY()
+	UCombatDamageSubsystem* DamageQueue;
+};
@@ -0,0 +1,281 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+#include "TimingWheel.h"
+
+enum class EStatusEffect : uint8
+{
+	/** Deals Magnitude damage every period */
+	DamageOverTime,
+	/** Heals Magnitude health every period */
+	HealOverTime,
+	/** Scales the walk speed by Magnitude while it lasts, below 1 slows, above 1 hastes */
+	MoveSpeed,
+	Count
+};
+
+/** What an effect does and for how long, in ticks of the table */
+struct FStatusEffectSpec
+{
+	EStatusEffect Type;
+	float Magnitude;
+	uint32 Duration;
+	/** Ticks between two applications, 0 for effects that only last */
+	uint32 Period;
+};
+
+/** Names an effect instance, stale once the effect ended and its storage was reused */
+struct FStatusEffectHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	FORCEINLINE bool IsValid() const { return Index != INDEX_NONE; }
+};
+
+/**
+ * Buffs and debuffs of up to MaxTargets fighters, at most Capacity effects alive at once.
+ * Effects live in one pooled array and every effect has a single entry in a hierarchical timing wheel, due at its
+ * next period or its expiry, whichever comes first, so periodic ticks and expiry cost O(1) amortized per effect.
+ * The effects of a target are linked together, so a target can be cleared and its walk speed rebuilt without a search.
+ * The same effect type from the same source on the same target refreshes instead of stacking.
+ * Fixed size and no allocations.
+ */
+template<int32 Capacity, int32 MaxTargets>
+class TStatusEffectTable
+{
+public:
+	static constexpr int32 TargetCapacity = MaxTargets;
+
+	TStatusEffectTable()
+	{
+		Reset(0);
+	}
+
+	/** Ends every effect without applying anything and restarts the clock at StartTick */
+	void Reset(uint32 StartTick)
+	{
+		Wheel.Reset(StartTick);
+		for (int32& Head : TargetHeads)
+		{
+			Head = INDEX_NONE;
+		}
+		// Free effects are chained through TargetNext
+		for (int32 Index = 0; Index < Capacity; Index++)
+		{
+			Effects[Index].Target = INDEX_NONE;
+			Effects[Index].TargetNext = Index + 1 < Capacity ? Index + 1 : INDEX_NONE;
+		}
+		FreeHead = 0;
+		NumEffects = 0;
+	}
+
+	FORCEINLINE int32 Num() const { return NumEffects; }
+	FORCEINLINE uint32 GetCurrentTick() const { return Wheel.GetCurrentTick(); }
+
+	/**
+	 * Starts an effect on a target from the current tick, or refreshes the duration and magnitude of the one of the same
+	 * type and source. Returns an invalid handle if the table is full.
+	 */
+	FStatusEffectHandle Apply(int32 Target, const FStatusEffectSpec& Spec, uint32 Source)
+	{
+		check(Target >= 0 && Target < MaxTargets && Spec.Duration > 0);
+		const uint32 Now = Wheel.GetCurrentTick();
+		int32 Index = FindEffect(Target, Spec.Type, Source);
+		if (Index == INDEX_NONE)
+		{
+			if (FreeHead == INDEX_NONE)
+			{
+				return FStatusEffectHandle();
+			}
+			Index = FreeHead;
+			FreeHead = Effects[Index].TargetNext;
+			LinkToTarget(Index, Target);
+			NumEffects++;
+
+			FEffect& Effect = Effects[Index];
+			Effect.Source = Source;
+			Effect.Type = Spec.Type;
+			Effect.Serial++;
+			Effect.Period = Spec.Period;
+			Effect.NextPeriodTick = Now + Spec.Period;
+		}
+		else
+		{
+			Wheel.Cancel(Index);
+		}
+
+		FEffect& Effect = Effects[Index];
+		Effect.Magnitude = Spec.Magnitude;
+		Effect.ExpireTick = Now + Spec.Duration;
+		Wheel.Schedule(Index, GetDueTick(Effect));
+
+		FStatusEffectHandle Handle;
+		Handle.Index = Index;
+		Handle.Serial = Effect.Serial;
+		return Handle;
+	}
+
+	/** Ends an effect early without applying it, returns false if it already ended */
+	bool Remove(const FStatusEffectHandle& Handle)
+	{
+		if (!IsAlive(Handle))
+		{
+			return false;
+		}
+		Wheel.Cancel(Handle.Index);
+		Release(Handle.Index);
+		return true;
+	}
+
+	/** Ends every effect of a target without applying them, returns true if one of them changed its speed */
+	bool RemoveTarget(int32 Target)
+	{
+		check(Target >= 0 && Target < MaxTargets);
+		bool bHadSpeed = false;
+		while (TargetHeads[Target] != INDEX_NONE)
+		{
+			const int32 Index = TargetHeads[Target];
+			bHadSpeed |= Effects[Index].Type == EStatusEffect::MoveSpeed;
+			Wheel.Cancel(Index);
+			Release(Index);
+		}
+		return bHadSpeed;
+	}
+
+	FORCEINLINE bool IsAlive(const FStatusEffectHandle& Handle) const
+	{
+		return Handle.Index >= 0 && Handle.Index < Capacity && Effects[Handle.Index].Target != INDEX_NONE && Effects[Handle.Index].Serial == Handle.Serial;
+	}
+	/** Type and target of an effect that is alive */
+	FORCEINLINE EStatusEffect GetType(const FStatusEffectHandle& Handle) const { return Effects[Handle.Index].Type; }
+	FORCEINLINE int32 GetTarget(const FStatusEffectHandle& Handle) const { return Effects[Handle.Index].Target; }
+
+	/** Product of the MoveSpeed effects of a target, 1 without any */
+	float GetSpeedScale(int32 Target) const
+	{
+		float Scale = 1.f;
+		for (int32 Index = TargetHeads[Target]; Index != INDEX_NONE; Index = Effects[Index].TargetNext)
+		{
+			Scale *= Effects[Index].Type == EStatusEffect::MoveSpeed ? Effects[Index].Magnitude : 1.f;
+		}
+		return Scale;
+	}
+
+	/**
+	 * Runs the clock up to ToTick. Handler gets OnEffectTick(Target, Type, Magnitude, Source) for every period that
+	 * came up and OnSpeedChanged(Target) after a MoveSpeed effect expired. A period falling on the expiry tick still
+	 * applies. The handler may apply and remove effects.
+	 */
+	template<typename HandlerType>
+	void Advance(uint32 ToTick, HandlerType& Handler)
+	{
+		Wheel.Advance(ToTick, [this, &Handler](int32 Index)
+		{
+			FEffect& Effect = Effects[Index];
+			const uint32 Now = Wheel.GetCurrentTick();
+			const int32 Target = Effect.Target;
+			if (Effect.Period > 0 && (int32)(Now - Effect.NextPeriodTick) >= 0)
+			{
+				Effect.NextPeriodTick += Effect.Period;
+				Handler.OnEffectTick(Target, Effect.Type, Effect.Magnitude, Effect.Source);
+				// The handler may have removed or refreshed the effect
+				if (Effect.Target != Target || Wheel.IsScheduled(Index))
+				{
+					return;
+				}
+			}
+
+			if ((int32)(Now - Effect.ExpireTick) >= 0)
+			{
+				const bool bSpeed = Effect.Type == EStatusEffect::MoveSpeed;
+				Release(Index);
+				if (bSpeed)
+				{
+					Handler.OnSpeedChanged(Target);
+				}
+			}
+			else
+			{
+				Wheel.Schedule(Index, GetDueTick(Effect));
+			}
+		});
+	}
+
+private:
+	struct FEffect
+	{
+		int32 Target;
+		/** Next effect of the same target, or the next free effect */
+		int32 TargetNext;
+		int32 TargetPrev;
+		uint32 Source;
+		uint32 Serial = 0;
+		float Magnitude;
+		uint32 ExpireTick;
+		uint32 NextPeriodTick;
+		uint32 Period;
+		EStatusEffect Type;
+	};
+
+	static FORCEINLINE uint32 GetDueTick(const FEffect& Effect)
+	{
+		return Effect.Period > 0 && (int32)(Effect.ExpireTick - Effect.NextPeriodTick) > 0 ? Effect.NextPeriodTick : Effect.ExpireTick;
+	}
+
+	int32 FindEffect(int32 Target, EStatusEffect Type, uint32 Source) const
+	{
+		for (int32 Index = TargetHeads[Target]; Index != INDEX_NONE; Index = Effects[Index].TargetNext)
+		{
+			if (Effects[Index].Type == Type && Effects[Index].Source == Source)
+			{
+				return Index;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	void LinkToTarget(int32 Index, int32 Target)
+	{
+		FEffect& Effect = Effects[Index];
+		Effect.Target = Target;
+		Effect.TargetPrev = INDEX_NONE;
+		Effect.TargetNext = TargetHeads[Target];
+		if (Effect.TargetNext != INDEX_NONE)
+		{
+			Effects[Effect.TargetNext].TargetPrev = Index;
+		}
+		TargetHeads[Target] = Index;
+	}
+
+	/** Unlinks an unscheduled effect from its target and puts it on the free list */
+	void Release(int32 Index)
+	{
+		FEffect& Effect = Effects[Index];
+		if (Effect.TargetPrev != INDEX_NONE)
+		{
+			Effects[Effect.TargetPrev].TargetNext = Effect.TargetNext;
+		}
+		else
+		{
+			TargetHeads[Effect.Target] = Effect.TargetNext;
+		}
+		if (Effect.TargetNext != INDEX_NONE)
+		{
+			Effects[Effect.TargetNext].TargetPrev = Effect.TargetPrev;
+		}
+		Effect.Target = INDEX_NONE;
+		Effect.TargetNext = FreeHead;
+		FreeHead = Index;
+		NumEffects--;
+	}
+
+	THierarchicalTimingWheel<Capacity> Wheel;
+	FEffect Effects[Capacity];
+	/** First effect of each target */
+	int32 TargetHeads[MaxTargets];
+	int32 FreeHead = INDEX_NONE;
+	int32 NumEffects = 0;
+};
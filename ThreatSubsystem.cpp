@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThreatSubsystem.h"
+#include "AICharacter.h"
+#include "BossFightCharacter.h"
+#include "BossFightStats.h"
+#include "CombatDamageSubsystem.h"
+#include "MeleeReachSubsystem.h"
+#include "Engine/World.h"
+
+void UThreatSubsystem::RegisterBoss(AAICharacter* Boss)
+{
+	check(Boss);
+	Boss->ThreatIndex = Bosses.Add(Boss);
+	Tables.AddDefaulted();
+}
+
+void UThreatSubsystem::UnregisterBoss(AAICharacter* Boss)
+{
+	const int32 ThreatIndex = Boss ? Boss->ThreatIndex : INDEX_NONE;
+	if (!Bosses.IsValidIndex(ThreatIndex) || Bosses[ThreatIndex] != Boss)
+	{
+		return;
+	}
+
+	Bosses.RemoveAtSwap(ThreatIndex, 1, false);
+	Tables.RemoveAtSwap(ThreatIndex, 1, false);
+	if (Bosses.IsValidIndex(ThreatIndex))
+	{
+		Bosses[ThreatIndex]->ThreatIndex = ThreatIndex;
+	}
+	Boss->ThreatIndex = INDEX_NONE;
+}
+
+void UThreatSubsystem::RemovePlayer(const ABossFightCharacter* Player)
+{
+	if (Player->DamageIndex == INDEX_NONE)
+	{
+		return;
+	}
+	for (FBossThreatTable& Table : Tables)
+	{
+		Table.Remove(Player->DamageIndex);
+	}
+}
+
+bool UThreatSubsystem::AddThreat(int32 ThreatIndex, const ABossFightCharacter* Player, float Amount)
+{
+	if (!Tables.IsValidIndex(ThreatIndex) || Player->DamageIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	NumUpdates++;
+	return Tables[ThreatIndex].AddThreat(Player->DamageIndex, Amount);
+}
+
+void UThreatSubsystem::AddDamageThreat(const AAICharacter* Boss, const ABossFightCharacter* Player, float Damage)
+{
+	AddThreat(Boss->ThreatIndex, Player, Damage * DamageThreat);
+}
+
+void UThreatSubsystem::AddHealingThreat(const ABossFightCharacter* Player, float Healing)
+{
+	// Healing does not pull a boss that never noticed the player
+	const int32 Key = Player->DamageIndex;
+	for (FBossThreatTable& Table : Tables)
+	{
+		if (Key != INDEX_NONE && Table.Contains(Key))
+		{
+			Table.AddThreat(Key, Healing * HealingThreat);
+			NumUpdates++;
+		}
+	}
+}
+
+ABossFightCharacter* UThreatSubsystem::GetTopTarget(const AAICharacter* Boss) const
+{
+	if (!Tables.IsValidIndex(Boss->ThreatIndex))
+	{
+		return nullptr;
+	}
+	const int32 Key = Tables[Boss->ThreatIndex].GetTop();
+	const UCombatDamageSubsystem* DamageQueue = GetWorld()->GetSubsystem<UCombatDamageSubsystem>();
+	return Key != INDEX_NONE ? Cast<ABossFightCharacter>(DamageQueue->GetOwner(Key)) : nullptr;
+}
+
+void UThreatSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UThreatSubsystem::Tick);
+	Super::Tick(DeltaTime);
+
+	if (Bosses.Num() == 0)
+	{
+		return;
+	}
+
+	const float ProximityThreat = ProximityThreatPerSecond * DeltaTime;
+	for (const FMeleeContact& Contact : GetWorld()->GetSubsystem<UMeleeReachSubsystem>()->GetContacts())
+	{
+		if (IsValid(Contact.Boss) && IsValid(Contact.Player))
+		{
+			AddThreat(Contact.Boss->ThreatIndex, Contact.Player, ProximityThreat);
+		}
+	}
+
+	FBossFightStats::SetThreatUpdates(NumUpdates);
+	NumUpdates = 0;
+}
+
+TStatId UThreatSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_BossFight_ThreatTick);
+}
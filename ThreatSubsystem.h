@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ThreatTable.h"
+#include "ThreatSubsystem.generated.h"
+
+class AAICharacter;
+class ABossFightCharacter;
+
+/**
+ * Threat of the players against every boss of the world, one TThreatTable per boss.
+ * Damage dealt to a boss, healing done while a boss already hates the healer and standing in melee reach of a boss
+ * all add threat. Players are keyed by their index in UCombatDamageSubsystem, so they leave the tables before they
+ * leave the damage subsystem. The skills of a boss land on the player at the top of its table.
+ * Server only, like the bosses' thinking.
+ */
+UCLASS()
+class BOSSFIGHT_API UThreatSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	typedef TThreatTable<64> FBossThreatTable;
+
+	/** Threat per point of damage dealt to the boss */
+	static constexpr float DamageThreat = 1.f;
+	/** Threat per point of health healed */
+	static constexpr float HealingThreat = 0.5f;
+	/** Threat per second of standing in melee reach of the boss */
+	static constexpr float ProximityThreatPerSecond = 10.f;
+
+	void RegisterBoss(AAICharacter* Boss);
+	void UnregisterBoss(AAICharacter* Boss);
+	/** Drops a player from every table, for players leaving the fight */
+	void RemovePlayer(const ABossFightCharacter* Player);
+
+	/** The player dealt Damage to the boss */
+	void AddDamageThreat(const AAICharacter* Boss, const ABossFightCharacter* Player, float Damage);
+	/** The player healed itself, every boss that already has it in its table hates it a bit more */
+	void AddHealingThreat(const ABossFightCharacter* Player, float Healing);
+
+	/** Player with the most threat against the boss, nullptr if nobody has any */
+	ABossFightCharacter* GetTopTarget(const AAICharacter* Boss) const;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Adds threat to a player in the table of a boss, returns false if the table is full */
+	bool AddThreat(int32 ThreatIndex, const ABossFightCharacter* Player, float Amount);
+
+	/** Per boss state, indexed by the ThreatIndex of the boss */
+	UPROPERTY()
+	TArray<AAICharacter*> Bosses;
+	TArray<FBossThreatTable> Tables;
+
+	/** Threat changes this frame, for stat BossFight */
+	int32 NumUpdates = 0;
+};
@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+
+/**
+ * Threat of up to Capacity attackers against one boss, kept in an indexed binary max-heap.
+ * Changing the threat of an attacker is O(log n) and reading the attacker with the most threat is O(1). Attackers are
+ * found by key through an open addressing hash that stores their heap position, so no update searches the heap.
+ * Attackers with equal threat come out in no particular order. Fixed size and no allocations.
+ */
+template<int32 Capacity>
+class TThreatTable
+{
+public:
+	static constexpr int32 MaxAttackers = Capacity;
+
+	TThreatTable()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		for (int32& SlotKey : SlotKeys)
+		{
+			SlotKey = INDEX_NONE;
+		}
+		NumAttackers = 0;
+	}
+
+	FORCEINLINE int32 Num() const { return NumAttackers; }
+	/** Attacker with the most threat, INDEX_NONE when the table is empty */
+	FORCEINLINE int32 GetTop() const { return NumAttackers > 0 ? HeapKeys[0] : INDEX_NONE; }
+	FORCEINLINE float GetTopThreat() const { return NumAttackers > 0 ? HeapThreats[0] : 0.f; }
+
+	FORCEINLINE bool Contains(int32 Key) const { return FindSlot(Key) != INDEX_NONE; }
+
+	/** Threat of an attacker, 0 if it is not in the table */
+	float GetThreat(int32 Key) const
+	{
+		const int32 Slot = FindSlot(Key);
+		return Slot != INDEX_NONE ? HeapThreats[SlotHeapIndices[Slot]] : 0.f;
+	}
+
+	/** Attackers in heap order, for walking the whole table */
+	FORCEINLINE int32 GetKeyAt(int32 Index) const { return HeapKeys[Index]; }
+	FORCEINLINE float GetThreatAt(int32 Index) const { return HeapThreats[Index]; }
+
+	/**
+	 * Adds Amount, which may be negative, to the threat of the attacker; a new attacker starts at 0.
+	 * Returns false if the attacker is new and the table is full.
+	 */
+	bool AddThreat(int32 Key, float Amount)
+	{
+		check(Key >= 0);
+		int32 Slot = FindSlot(Key);
+		if (Slot == INDEX_NONE)
+		{
+			if (NumAttackers == Capacity)
+			{
+				return false;
+			}
+			Slot = InsertSlot(Key);
+			Place(NumAttackers++, Key, 0.f, Slot);
+		}
+
+		const int32 HeapIndex = SlotHeapIndices[Slot];
+		HeapThreats[HeapIndex] += Amount;
+		if (Amount >= 0.f)
+		{
+			SiftUp(HeapIndex);
+		}
+		else
+		{
+			SiftDown(HeapIndex);
+		}
+		return true;
+	}
+
+	/** Drops the attacker, does nothing if it is not in the table */
+	void Remove(int32 Key)
+	{
+		const int32 Slot = FindSlot(Key);
+		if (Slot == INDEX_NONE)
+		{
+			return;
+		}
+		const int32 HeapIndex = SlotHeapIndices[Slot];
+		RemoveSlot(Slot);
+
+		// The last entry fills the gap and goes whichever way its threat sends it
+		const int32 Last = --NumAttackers;
+		if (HeapIndex != Last)
+		{
+			Place(HeapIndex, HeapKeys[Last], HeapThreats[Last], HeapSlots[Last]);
+			if (HeapIndex > 0 && HeapThreats[(HeapIndex - 1) / 2] < HeapThreats[HeapIndex])
+			{
+				SiftUp(HeapIndex);
+			}
+			else
+			{
+				SiftDown(HeapIndex);
+			}
+		}
+	}
+
+	/** Multiplies every threat by a non-negative Factor, which keeps the heap order so nothing moves */
+	void Scale(float Factor)
+	{
+		check(Factor >= 0.f);
+		for (int32 Index = 0; Index < NumAttackers; Index++)
+		{
+			HeapThreats[Index] *= Factor;
+		}
+	}
+
+private:
+	static constexpr int32 CountSlotBits()
+	{
+		// At most half full, so probe sequences stay short
+		int32 Bits = 1;
+		while ((1 << Bits) < 2 * Capacity)
+		{
+			Bits++;
+		}
+		return Bits;
+	}
+	static constexpr int32 SlotBits = CountSlotBits();
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr int32 SlotMask = NumSlots - 1;
+
+	/** Fibonacci hashing, takes the high bits so dense keys spread over the slots */
+	static FORCEINLINE int32 GetHomeSlot(int32 Key)
+	{
+		return (int32)(((uint32)Key * 2654435769u) >> (32 - SlotBits));
+	}
+
+	int32 FindSlot(int32 Key) const
+	{
+		for (int32 Slot = GetHomeSlot(Key); SlotKeys[Slot] != INDEX_NONE; Slot = (Slot + 1) & SlotMask)
+		{
+			if (SlotKeys[Slot] == Key)
+			{
+				return Slot;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	int32 InsertSlot(int32 Key)
+	{
+		int32 Slot = GetHomeSlot(Key);
+		while (SlotKeys[Slot] != INDEX_NONE)
+		{
+			Slot = (Slot + 1) & SlotMask;
+		}
+		SlotKeys[Slot] = Key;
+		return Slot;
+	}
+
+	/** Linear probing without tombstones: later keys of the probe sequence shift back into the hole */
+	void RemoveSlot(int32 Slot)
+	{
+		int32 Hole = Slot;
+		for (int32 Next = (Hole + 1) & SlotMask; SlotKeys[Next] != INDEX_NONE; Next = (Next + 1) & SlotMask)
+		{
+			// A key may only move back as far as its home slot
+			const int32 Home = GetHomeSlot(SlotKeys[Next]);
+			if (((Next - Home) & SlotMask) >= ((Next - Hole) & SlotMask))
+			{
+				SlotKeys[Hole] = SlotKeys[Next];
+				SlotHeapIndices[Hole] = SlotHeapIndices[Next];
+				HeapSlots[SlotHeapIndices[Hole]] = Hole;
+				Hole = Next;
+			}
+		}
+		SlotKeys[Hole] = INDEX_NONE;
+	}
+
+	FORCEINLINE void Place(int32 HeapIndex, int32 Key, float Threat, int32 Slot)
+	{
+		HeapKeys[HeapIndex] = Key;
+		HeapThreats[HeapIndex] = Threat;
+		HeapSlots[HeapIndex] = Slot;
+		SlotHeapIndices[Slot] = HeapIndex;
+	}
+
+	void SiftUp(int32 HeapIndex)
+	{
+		const int32 Key = HeapKeys[HeapIndex];
+		const float Threat = HeapThreats[HeapIndex];
+		const int32 Slot = HeapSlots[HeapIndex];
+		while (HeapIndex > 0)
+		{
+			const int32 Parent = (HeapIndex - 1) / 2;
+			if (HeapThreats[Parent] >= Threat)
+			{
+				break;
+			}
+			Place(HeapIndex, HeapKeys[Parent], HeapThreats[Parent], HeapSlots[Parent]);
+			HeapIndex = Parent;
+		}
+		Place(HeapIndex, Key, Threat, Slot);
+	}
+
+	void SiftDown(int32 HeapIndex)
+	{
+		const int32 Key = HeapKeys[HeapIndex];
+		const float Threat = HeapThreats[HeapIndex];
+		const int32 Slot = HeapSlots[HeapIndex];
+		for (;;)
+		{
+			int32 Child = 2 * HeapIndex + 1;
+			if (Child >= NumAttackers)
+			{
+				break;
+			}
+			if (Child + 1 < NumAttackers && HeapThreats[Child + 1] > HeapThreats[Child])
+			{
+				Child++;
+			}
+			if (HeapThreats[Child] <= Threat)
+			{
+				break;
+			}
+			Place(HeapIndex, HeapKeys[Child], HeapThreats[Child], HeapSlots[Child]);
+			HeapIndex = Child;
+		}
+		Place(HeapIndex, Key, Threat, Slot);
+	}
+
+	/** Heap of the attackers, ordered by threat, and the hash slot of each */
+	int32 HeapKeys[Capacity];
+	float HeapThreats[Capacity];
+	int32 HeapSlots[Capacity];
+	int32 NumAttackers = 0;
+
+	/** Key of each hash slot, INDEX_NONE when free, and the heap index of that key */
+	int32 SlotKeys[NumSlots];
+	int32 SlotHeapIndices[NumSlots];
+};
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CombatCoreDefines.h"
+
+/**
+ * Hierarchical timing wheel over the ids 0 to Capacity - 1, the caller owns whatever the ids stand for.
+ * Four levels of 64 slots each cover 2^24 ticks ahead; level L holds the ids due within 64^(L + 1) ticks, in the slot
+ * of the matching bits of their due tick, and is cascaded one level down when the lower levels wrap. Scheduling and
+ * cancelling are O(1), every id is moved at most once per level, so an expiry costs O(1) amortized whatever the
+ * number of scheduled ids. Slots are intrusive doubly linked lists through the ids. Fixed size and no allocations.
+ */
+template<int32 Capacity>
+class THierarchicalTimingWheel
+{
+public:
+	static constexpr int32 NumLevels = 4;
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	/** Ids due further ahead wait in the last level until they come within range */
+	static constexpr uint32 MaxDelay = (1u << (NumLevels * SlotBits)) - 1;
+
+	THierarchicalTimingWheel()
+	{
+		Reset(0);
+	}
+
+	/** Unschedules every id and restarts at StartTick */
+	void Reset(uint32 StartTick)
+	{
+		for (int32& Head : Heads)
+		{
+			Head = INDEX_NONE;
+		}
+		for (int16& Bucket : Buckets)
+		{
+			Bucket = INDEX_NONE;
+		}
+		CurrentTick = StartTick;
+		NumScheduled = 0;
+	}
+
+	/** Last tick Advance went through */
+	FORCEINLINE uint32 GetCurrentTick() const { return CurrentTick; }
+	FORCEINLINE int32 Num() const { return NumScheduled; }
+	FORCEINLINE bool IsScheduled(int32 Id) const { return Buckets[Id] != INDEX_NONE; }
+
+	/** Schedules an id that is not scheduled yet; due ticks that already went by are moved to the next one */
+	void Schedule(int32 Id, uint32 DueTick)
+	{
+		check(Id >= 0 && Id < Capacity && !IsScheduled(Id));
+		// Ticks wrap after years, compare through the difference
+		DueTicks[Id] = (int32)(DueTick - CurrentTick) > 0 ? DueTick : CurrentTick + 1;
+		Insert(Id, CurrentTick);
+		NumScheduled++;
+	}
+
+	/** Unschedules an id, does nothing if it is not scheduled */
+	void Cancel(int32 Id)
+	{
+		if (IsScheduled(Id))
+		{
+			Unlink(Id);
+			NumScheduled--;
+		}
+	}
+
+	/**
+	 * Goes through every tick up to ToTick and calls OnDue(Id) for each id due, in tick order.
+	 * The id is unscheduled before the call, OnDue may schedule or cancel any id.
+	 */
+	template<typename FuncType>
+	void Advance(uint32 ToTick, FuncType&& OnDue)
+	{
+		while ((int32)(ToTick - CurrentTick) > 0)
+		{
+			if (NumScheduled == 0)
+			{
+				CurrentTick = ToTick;
+				return;
+			}
+
+			const uint32 Tick = CurrentTick + 1;
+			for (int32 Level = 1; Level < NumLevels && (Tick & ((1u << (Level * SlotBits)) - 1)) == 0; Level++)
+			{
+				Cascade(Level, Tick);
+			}
+
+			// Ids scheduled from OnDue land on later ticks, so the slot drains
+			CurrentTick = Tick;
+			int32& Head = Heads[Tick & (NumSlots - 1)];
+			while (Head != INDEX_NONE)
+			{
+				const int32 Id = Head;
+				Unlink(Id);
+				NumScheduled--;
+				OnDue(Id);
+			}
+		}
+	}
+
+private:
+	/** Puts an id in the slot of its due tick relative to BaseTick */
+	void Insert(int32 Id, uint32 BaseTick)
+	{
+		const uint32 Delay = DueTicks[Id] - BaseTick;
+		const uint32 SlotTick = Delay <= MaxDelay ? DueTicks[Id] : BaseTick + MaxDelay;
+		int32 Level = 0;
+		while (Level < NumLevels - 1 && Delay >= (1u << ((Level + 1) * SlotBits)))
+		{
+			Level++;
+		}
+		const int32 Bucket = Level * NumSlots + (int32)((SlotTick >> (Level * SlotBits)) & (NumSlots - 1));
+
+		int32& Head = Heads[Bucket];
+		Prev[Id] = INDEX_NONE;
+		Next[Id] = Head;
+		if (Head != INDEX_NONE)
+		{
+			Prev[Head] = Id;
+		}
+		Head = Id;
+		Buckets[Id] = (int16)Bucket;
+	}
+
+	FORCEINLINE void Unlink(int32 Id)
+	{
+		if (Prev[Id] != INDEX_NONE)
+		{
+			Next[Prev[Id]] = Next[Id];
+		}
+		else
+		{
+			Heads[Buckets[Id]] = Next[Id];
+		}
+		if (Next[Id] != INDEX_NONE)
+		{
+			Prev[Next[Id]] = Prev[Id];
+		}
+		Buckets[Id] = INDEX_NONE;
+	}
+
+	/** Moves the ids of the slot of a level that comes up at Tick to the levels below */
+	void Cascade(int32 Level, uint32 Tick)
+	{
+		int32& Head = Heads[Level * NumSlots + (int32)((Tick >> (Level * SlotBits)) & (NumSlots - 1))];
+		int32 Id = Head;
+		Head = INDEX_NONE;
+		while (Id != INDEX_NONE)
+		{
+			const int32 NextId = Next[Id];
+			Insert(Id, Tick);
+			Id = NextId;
+		}
+	}
+
+	int32 Heads[NumLevels * NumSlots];
+	int32 Next[Capacity];
+	int32 Prev[Capacity];
+	uint32 DueTicks[Capacity];
+	/** Level and slot of each id, INDEX_NONE when not scheduled */
+	int16 Buckets[Capacity];
+	uint32 CurrentTick = 0;
+	int32 NumScheduled = 0;
+};